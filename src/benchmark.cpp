@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "spellbook.h"
+#include "generator.h"
+#include "synthetic_corpus.h"
+
+/*
+	Synthesizes a corpus of annotated headers, runs every stage of the pipeline on it
+	and reports the throughput of each stage, taking the best of several runs.
+*/
+
+using namespace std::chrono;
+
+static generator_configuration make_benchmark_configuration(const std::string& directory) {
+	generator_configuration cfg;
+
+	cfg.beginning_line = "// GEN INTROSPECTOR";
+	cfg.ending_line = "// END GEN INTROSPECTOR";
+	cfg.header_directories = { (fs::path(directory) / "headers").string() };
+
+	cfg.generated_file_path = (fs::path(directory) / "generated_introspectors.h").string();
+	cfg.generated_enums_path = (fs::path(directory) / "generated_enums.h").string();
+	cfg.generated_specializations_path = (fs::path(directory) / "generated_specializations.h").string();
+
+	cfg.introspector_field_format = format_template("\t\t\tFIELD(%x); /* %x */\n");
+	cfg.introspector_body_format = format_template("\t\ttemplate <class F%x, class... Instances>\n\t\tstatic void introspect_body(\n\t\t\t%x,\n\t\t\tF f,\n\t\t\tInstances&&... _t_\n\t\t) {\n%x\t\t}\n\n");
+	cfg.specialized_list_format = format_template("template <class __T%x>\nstruct types_in<%x, __T> {\n\tusing types = type_list<%x>;\n};\n\n");
+	cfg.enum_field_format = format_template("\t\tcase T::%x: return TOSTR;\n");
+	cfg.enum_introspector_body_format = format_template("\tinline const char* enum_to_string(const %x e) {\n\t\t/* %x */\n\t\tswitch(e) {\n%x\t\tdefault: return \"Invalid\";\n\t\t}\n\t}\n\t/* count: %x */\n\n");
+	cfg.enum_arg_format = format_template("\t\t\tT::%x,\n");
+	cfg.enum_to_args_body_format = format_template("\ttemplate <class F>\n\tvoid enum_to_args_impl(const %x e, F f) {\n\t\tf(\n%x\t\t);\n\t}\n\n");
+	cfg.generated_file_format = format_template("#pragma once\n#define FIELD(x) f(#x, _t_.x...)\n\n%xnamespace augs {\n\tstruct introspection_access {\n%x\t};\n}\n");
+
+	return cfg;
+}
+
+struct phase_result {
+	std::string name;
+	double best_ms = 0.0;
+
+	/* What one run of the phase processes */
+	std::size_t files = 0;
+	std::size_t fields = 0;
+	std::uintmax_t bytes = 0;
+};
+
+static void print_result(const phase_result& r) {
+	const auto seconds = r.best_ms / 1000.0;
+
+	auto per_second = [&](const double amount) {
+		return seconds > 0.0 ? amount / seconds : 0.0;
+	};
+
+	std::cout << std::left << std::setw(28) << r.name << std::right << std::fixed << std::setprecision(3)
+		<< std::setw(12) << r.best_ms << " ms"
+		<< std::setprecision(0)
+		<< std::setw(14) << per_second(static_cast<double>(r.files)) << " files/s"
+		<< std::setw(14) << per_second(static_cast<double>(r.fields)) << " fields/s"
+		<< std::setprecision(1)
+		<< std::setw(10) << per_second(static_cast<double>(r.bytes) / (1024.0 * 1024.0)) << " MB/s"
+		<< std::endl;
+}
+
+int main(int argc, char** argv) {
+	synthetic_corpus_settings settings;
+
+	std::size_t num_jobs = get_default_num_jobs();
+	std::size_t num_runs = 5;
+	std::string directory = (fs::temp_directory_path() / "introspector-generator-benchmark").string();
+	bool keep = false;
+
+	for (int a = 1; a < argc; ++a) {
+		const std::string arg = argv[a];
+
+		auto next_number = [&]() {
+			return a + 1 < argc ? static_cast<std::size_t>(std::strtoul(argv[++a], nullptr, 10)) : std::size_t(0);
+		};
+
+		if (arg == "--headers") {
+			settings.num_headers = next_number();
+		}
+		else if (arg == "--structs") {
+			settings.structs_per_header = next_number();
+		}
+		else if (arg == "--enums") {
+			settings.enums_per_header = next_number();
+		}
+		else if (arg == "--fields") {
+			settings.fields_per_struct = next_number();
+		}
+		else if (arg == "--jobs") {
+			num_jobs = next_number();
+		}
+		else if (arg == "--runs") {
+			num_runs = std::max<std::size_t>(next_number(), 1);
+		}
+		else if (arg == "--directory" && a + 1 < argc) {
+			directory = argv[++a];
+		}
+		else if (arg == "--keep") {
+			keep = true;
+		}
+		else {
+			std::cout << "usage: [--headers N] [--structs N] [--enums N] [--fields N] [--jobs N] [--runs N] [--directory path] [--keep]" << std::endl;
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	/*
+		The directory may well be the user's own, e.g. --directory .,
+		so only a subdirectory that the benchmark owns is ever removed.
+	*/
+
+	const auto corpus_directory = (fs::path(directory) / "introspector-benchmark-corpus").string();
+
+	fs::remove_all(corpus_directory);
+
+	const auto cfg = make_benchmark_configuration(corpus_directory);
+
+	const auto synthesis_start = high_resolution_clock::now();
+	const auto corpus = write_synthetic_corpus(cfg.header_directories[0], settings);
+	const auto synthesis_ms = duration_cast<duration<double, milliseconds::period>>(high_resolution_clock::now() - synthesis_start).count();
+
+	std::cout << "------------\nIntrospector-generator benchmark" << std::endl;
+	std::cout << "Corpus: " << corpus.num_headers << " headers, " << corpus.num_types << " types, " << corpus.num_fields << " fields, "
+		<< corpus.num_bytes << " bytes (written in " << synthesis_ms << " ms)" << std::endl;
+	std::cout << "Jobs: " << num_jobs << ", runs: " << num_runs << " (best run reported)" << std::endl << std::endl;
+
+	auto measure = [num_runs](phase_result r, const std::function<void()>& before_run, const std::function<void()>& run) {
+		r.best_ms = std::numeric_limits<double>::max();
+
+		for (std::size_t i = 0; i < num_runs; ++i) {
+			before_run();
+
+			const auto start = high_resolution_clock::now();
+			run();
+			r.best_ms = std::min(r.best_ms, duration_cast<duration<double, milliseconds::period>>(high_resolution_clock::now() - start).count());
+		}
+
+		print_result(r);
+		return r;
+	};
+
+	const auto nothing = []() {};
+
+	std::vector<std::string> header_files;
+	scan_cache model;
+
+	scan_cache no_cache;
+	no_cache.beginning_line = cfg.beginning_line;
+	no_cache.ending_line = cfg.ending_line;
+
+	measure({ "find_header_files", 0.0, corpus.num_headers, 0, 0 }, nothing, [&]() {
+		header_files = find_header_files(cfg);
+	});
+
+	measure({ "scan_headers (no cache)", 0.0, corpus.num_headers, corpus.num_fields, corpus.num_bytes }, nothing, [&]() {
+		model = make_scan_cache(cfg, header_files, scan_headers(header_files, no_cache, num_jobs));
+	});
+
+	measure({ "scan_headers (cached)", 0.0, corpus.num_headers, corpus.num_fields, corpus.num_bytes }, nothing, [&]() {
+		model = make_scan_cache(cfg, header_files, scan_headers(header_files, model, num_jobs));
+	});
+
+	const auto cache_path = get_scan_cache_path(cfg.generated_file_path);
+
+	measure({ "save_scan_cache", 0.0, corpus.num_headers, corpus.num_fields, 0 }, nothing, [&]() {
+		save_scan_cache(cache_path, model);
+	});
+
+	measure({ "load_scan_cache", 0.0, corpus.num_headers, corpus.num_fields, 0 }, nothing, [&]() {
+		load_scan_cache(cache_path, cfg.beginning_line, cfg.ending_line);
+	});
+
+	const auto output_bytes = [&]() {
+		const auto outputs = generate_outputs(cfg, header_files, model);
+		return outputs.generated_file.size() + outputs.generated_specializations.size() + outputs.generated_enums.size();
+	}();
+
+	measure({ "generate_outputs (memory)", 0.0, corpus.num_headers, corpus.num_fields, output_bytes }, nothing, [&]() {
+		generate_outputs(cfg, header_files, model);
+	});
+
+	auto remove_outputs = [&]() {
+		fs::remove(cfg.generated_file_path);
+		fs::remove(cfg.generated_specializations_path);
+		fs::remove(cfg.generated_enums_path);
+		model.outputs.clear();
+	};
+
+	measure({ "write_outputs (changed)", 0.0, corpus.num_headers, corpus.num_fields, output_bytes }, remove_outputs, [&]() {
+		write_outputs(cfg, header_files, model);
+	});
+
+	measure({ "write_outputs (unchanged)", 0.0, corpus.num_headers, corpus.num_fields, output_bytes }, nothing, [&]() {
+		write_outputs(cfg, header_files, model);
+	});
+
+	std::cout << std::endl << "Generated: " << output_bytes << " bytes" << std::endl;
+	std::cout << "------------" << std::endl;
+
+	if (!keep) {
+		fs::remove_all(corpus_directory);
+	}
+
+	return 0;
+}
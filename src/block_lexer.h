@@ -0,0 +1,714 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "block_line.h"
+
+/*
+	Turns the lines of a GEN INTROSPECTOR block into block_lines, visiting every character once.
+
+	Inside a struct or class, a member declaration runs until the semicolon at the outermost level,
+	so it may span several lines and declare several comma-separated fields.
+	Whitespace within a line is kept as written, and a line break becomes a single space.
+	Comments are dropped wherever they are, and so are:
+	access specifiers, friend, using and typedef declarations,
+	member functions, nested type definitions and member templates.
+
+	Inside an enum, every comma-separated enumerator is a field.
+
+	Preprocessor lines and blank lines are kept intact,
+	but only between declarations, since a field is emitted only once its declaration is complete.
+
+	The only comments that matter are the // comments made of tags alone, e.g. // @net @nosave.
+	Any other comment, e.g. // @brief or // mail me@example.com, carries no tags.
+	Tags apply to all the fields completed on the line of the comment,
+	and to all the fields of a declaration that is still pending.
+	A block may use at most 32 different tags.
+
+	feed and finish return false on bad syntax, so that the caller can report the current line.
+*/
+
+class block_lexer {
+	static constexpr auto npos = std::string::npos;
+
+	struct declarator {
+		std::size_t begin = 0;
+
+		/* Where the name ends, i.e. the position of the first '=', '{', '(', '[' or ':' after it */
+		std::size_t head_end = npos;
+	};
+
+	const bool is_enum;
+
+	bool in_block_comment = false;
+	char in_literal = 0;
+
+	std::string declaration;
+	std::vector<declarator> declarators = { declarator() };
+
+	int depth = 0;
+	int angle_depth = 0;
+
+	bool in_initializer = false;
+	bool is_function = false;
+	bool has_array = false;
+	bool has_body = false;
+
+	/* In enums, only the first word of an enumerator is its name */
+	bool enumerator_complete = false;
+
+	std::vector<std::string> tag_names;
+
+	/* Tags from the lines of the pending declaration */
+	std::uint32_t pending_tags = 0;
+
+	static bool is_space(const char c) {
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+	}
+
+	/* Characters that may change the state of a member declaration */
+
+	static bool is_member_special(const char c) {
+		switch (c) {
+			case ' ': case '\t': case '\r': case '\n': case '\v': case '\f':
+			case '"': case '\'': case '/':
+			case '(': case ')': case '[': case ']': case '{': case '}': case '<': case '>':
+			case '=': case ',': case ':': case ';':
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	static bool is_identifier_char(const char c) {
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+	}
+
+	static std::string_view trim(std::string_view s) {
+		while (!s.empty() && is_space(s.front())) {
+			s.remove_prefix(1);
+		}
+
+		while (!s.empty() && is_space(s.back())) {
+			s.remove_suffix(1);
+		}
+
+		return s;
+	}
+
+	/*
+		The type that all declarators of a declaration share, i.e. the type of the first one
+		without its own '*' and '&', e.g. "const char" for "const char* s, c".
+	*/
+
+	static std::string_view get_base_type(const std::string_view first_type) {
+		int nesting = 0;
+
+		for (std::size_t i = 0; i < first_type.size(); ++i) {
+			switch (first_type[i]) {
+				case '<': case '(': case '[':
+					++nesting;
+					break;
+
+				case '>': case ')': case ']':
+					--nesting;
+					break;
+
+				case '*': case '&':
+					if (nesting == 0) {
+						return trim(first_type.substr(0, i));
+					}
+
+					break;
+
+				default:
+					break;
+			}
+		}
+
+		return first_type;
+	}
+
+	std::string_view get_first_word() const {
+		std::size_t end = 0;
+
+		while (end < declaration.size() && is_identifier_char(declaration[end])) {
+			++end;
+		}
+
+		return std::string_view(declaration).substr(0, end);
+	}
+
+	std::string_view get_last_word() const {
+		auto end = declaration.size();
+
+		while (end > 0 && is_space(declaration[end - 1])) {
+			--end;
+		}
+
+		auto begin = end;
+
+		while (begin > 0 && is_identifier_char(declaration[begin - 1])) {
+			--begin;
+		}
+
+		return std::string_view(declaration).substr(begin, end - begin);
+	}
+
+	/* Parentheses after these belong to the type, e.g. decltype(a) b; or alignas(8) int c; */
+
+	bool is_specifier_with_arguments() const {
+		const auto last_word = get_last_word();
+
+		return
+			last_word == "decltype"
+			|| last_word == "alignas"
+			|| last_word == "noexcept"
+			|| last_word == "__attribute__"
+			|| last_word == "__declspec"
+		;
+	}
+
+	void end_head() {
+		auto& d = declarators.back();
+
+		if (d.head_end == npos) {
+			d.head_end = declaration.size();
+		}
+	}
+
+	void reset() {
+		declaration.clear();
+		declarators.clear();
+		declarators.emplace_back();
+
+		depth = 0;
+		angle_depth = 0;
+
+		in_initializer = false;
+		is_function = false;
+		has_array = false;
+		has_body = false;
+
+		pending_tags = 0;
+	}
+
+	static bool is_tag_comment(const std::string_view comment) {
+		bool any = false;
+
+		for (std::size_t i = 0; i < comment.size();) {
+			if (is_space(comment[i])) {
+				++i;
+				continue;
+			}
+
+			if (comment[i] != '@') {
+				return false;
+			}
+
+			auto end = i + 1;
+
+			while (end < comment.size() && is_identifier_char(comment[end])) {
+				++end;
+			}
+
+			if (end == i + 1 || (end < comment.size() && !is_space(comment[end]))) {
+				return false;
+			}
+
+			any = true;
+			i = end;
+		}
+
+		return any;
+	}
+
+	bool read_tags(const std::string_view comment, std::uint32_t& tags) {
+		if (!is_tag_comment(comment)) {
+			return true;
+		}
+
+		for (auto at = comment.find('@'); at != std::string_view::npos; at = comment.find('@', at + 1)) {
+			auto end = at + 1;
+
+			while (end < comment.size() && is_identifier_char(comment[end])) {
+				++end;
+			}
+
+			const auto tag = comment.substr(at + 1, end - at - 1);
+			const auto index = static_cast<std::size_t>(std::find(tag_names.begin(), tag_names.end(), tag) - tag_names.begin());
+
+			if (index == tag_names.size()) {
+				if (index == 32) {
+					return false;
+				}
+
+				tag_names.emplace_back(tag);
+			}
+
+			tags |= std::uint32_t(1) << index;
+		}
+
+		return true;
+	}
+
+	bool is_skipped_declaration() const {
+		const auto first_word = get_first_word();
+
+		return
+			has_body
+			|| is_function
+			|| first_word == "friend"
+			|| first_word == "using"
+			|| first_word == "typedef"
+			|| first_word == "template"
+		;
+	}
+
+	bool complete_declaration(std::vector<block_line>& out) {
+		if (declaration.empty() || is_skipped_declaration()) {
+			reset();
+			return true;
+		}
+
+		if (has_array) {
+			return false;
+		}
+
+		/* A failure throws away the whole block, so fields can go straight to the output */
+
+		std::string_view base_type;
+
+		for (std::size_t i = 0; i < declarators.size(); ++i) {
+			const auto& d = declarators[i];
+			const auto head = std::string_view(declaration).substr(
+				d.begin,
+				(d.head_end == npos ? declaration.size() : d.head_end) - d.begin
+			);
+
+			auto name_end = head.size();
+
+			while (name_end > 0 && is_space(head[name_end - 1])) {
+				--name_end;
+			}
+
+			auto name_begin = name_end;
+
+			while (name_begin > 0 && is_identifier_char(head[name_begin - 1])) {
+				--name_begin;
+			}
+
+			const auto name = head.substr(name_begin, name_end - name_begin);
+
+			if (name.empty() || (name[0] >= '0' && name[0] <= '9')) {
+				return false;
+			}
+
+			const auto type_part = trim(head.substr(0, name_begin));
+
+			if (i == 0) {
+				if (type_part.empty()) {
+					return false;
+				}
+
+				base_type = get_base_type(type_part);
+				out.push_back({ block_line_type::FIELD, 0, std::string(name), std::string(type_part) });
+			}
+			else {
+				/* Whatever stands before a subsequent declarator, e.g. '*' or '&', belongs to its type alone */
+				out.push_back({ block_line_type::FIELD, 0, std::string(name), std::string(base_type) + std::string(type_part) });
+			}
+
+			out.back().tags = pending_tags;
+		}
+
+		reset();
+		return true;
+	}
+
+	/*
+		Operator names may contain brackets and '=', e.g. "operator<=" or "operator[]",
+		so a member operator is known by its keyword before any of these is seen.
+	*/
+
+	void note_operator_keyword(const std::string_view run) {
+		if (is_function || depth != 0 || angle_depth != 0 || in_initializer) {
+			return;
+		}
+
+		for (auto at = run.find("operator"); at != std::string_view::npos; at = run.find("operator", at + 1)) {
+			const auto end = at + 8;
+
+			if ((at == 0 || !is_identifier_char(run[at - 1])) && (end == run.size() || !is_identifier_char(run[end]))) {
+				end_head();
+				is_function = true;
+				return;
+			}
+		}
+	}
+
+	void append(const char c) {
+		declaration += c;
+	}
+
+	void append_space() {
+		if (!declaration.empty() && !is_space(declaration.back())) {
+			declaration += ' ';
+		}
+	}
+
+	/* A declaration that continues on the next line gets a single space in place of the line break */
+
+	void break_line() {
+		while (!declaration.empty() && is_space(declaration.back())) {
+			declaration.pop_back();
+		}
+
+		append_space();
+	}
+
+	bool complete_enumerator(std::vector<block_line>& out) {
+		if (!declaration.empty()) {
+			out.push_back({ block_line_type::FIELD, 0, declaration, {} });
+		}
+
+		declaration.clear();
+		enumerator_complete = false;
+
+		return true;
+	}
+
+	bool feed_enum_char(const char c, std::vector<block_line>& out) {
+		if (c == '=') {
+			/* Enumerators must be contiguous */
+			return false;
+		}
+
+		if (c == ',') {
+			return complete_enumerator(out);
+		}
+
+		if (is_space(c)) {
+			enumerator_complete = !declaration.empty();
+			return true;
+		}
+
+		if (!enumerator_complete) {
+			append(c);
+		}
+
+		return true;
+	}
+
+	bool feed_member_char(const std::string_view line, std::size_t& i, std::vector<block_line>& out) {
+		const auto c = line[i];
+		const bool at_head = depth == 0 && angle_depth == 0 && !in_initializer;
+
+		switch (c) {
+			case '"':
+			case '\'':
+				in_literal = c;
+				append(c);
+				return true;
+
+			case '(':
+			case '[':
+				if (c == '[' && i + 1 < line.size() && line[i + 1] == '[') {
+					/* An attribute group, e.g. [[no_unique_address]], is not an array */
+					depth += 2;
+					append(c);
+					append(c);
+					++i;
+					return true;
+				}
+
+				if (at_head && !(c == '(' && is_specifier_with_arguments())) {
+					end_head();
+
+					if (c == '(') {
+						is_function = true;
+					}
+					else {
+						has_array = true;
+					}
+				}
+
+				++depth;
+				append(c);
+				return true;
+
+			case '{':
+				if (depth == 0 && angle_depth == 0) {
+					const auto first_word = get_first_word();
+
+					if (is_function || first_word == "struct" || first_word == "class" || first_word == "union" || first_word == "enum") {
+						has_body = true;
+					}
+					else if (!in_initializer) {
+						end_head();
+						in_initializer = true;
+					}
+				}
+
+				++depth;
+				append(c);
+				return true;
+
+			case ')':
+			case ']':
+			case '}':
+				if (depth == 0) {
+					return false;
+				}
+
+				--depth;
+				append(c);
+
+				if (c == '}' && depth == 0 && has_body) {
+					return complete_declaration(out);
+				}
+
+				return true;
+
+			case '<':
+				if (depth == 0 && !in_initializer && !is_function) {
+					++angle_depth;
+				}
+
+				append(c);
+				return true;
+
+			case '>':
+				if (depth == 0 && angle_depth > 0 && !in_initializer && !is_function) {
+					--angle_depth;
+				}
+
+				append(c);
+				return true;
+
+			case '=':
+				if (at_head) {
+					end_head();
+					in_initializer = true;
+				}
+
+				append(c);
+				return true;
+
+			case ',':
+				if (depth == 0 && angle_depth == 0 && !has_body) {
+					end_head();
+					append(c);
+
+					declarator next;
+					next.begin = declaration.size();
+					declarators.push_back(next);
+
+					in_initializer = false;
+					return true;
+				}
+
+				append(c);
+				return true;
+
+			case ':':
+				if (i + 1 < line.size() && line[i + 1] == ':') {
+					append(c);
+					append(c);
+					++i;
+					return true;
+				}
+
+				if (at_head) {
+					const auto label = trim(declaration);
+
+					if (label == "public" || label == "protected" || label == "private") {
+						reset();
+						return true;
+					}
+
+					/* A bit-field, or a constructor's initializer list */
+					end_head();
+					in_initializer = true;
+				}
+
+				append(c);
+				return true;
+
+			case ';':
+				if (depth == 0) {
+					return complete_declaration(out);
+				}
+
+				append(c);
+				return true;
+
+			default:
+				/* Whitespace within a line is kept as written, so that types keep their spelling */
+				if (!is_space(c) || !declaration.empty()) {
+					append(c);
+				}
+
+				return true;
+		}
+	}
+
+public:
+	explicit block_lexer(const bool is_enum) : is_enum(is_enum) {}
+
+	bool feed(const std::string_view line, std::vector<block_line>& out) {
+		std::size_t first = 0;
+
+		if (!in_block_comment) {
+			while (first < line.size() && is_space(line[first])) {
+				++first;
+			}
+
+			const bool is_blank = first == line.size();
+			const bool is_preprocessor = !is_blank && line[first] == '#';
+
+			if (declaration.empty()) {
+				if (is_blank || is_preprocessor) {
+					out.push_back({ block_line_type::INTACT, 0, std::string(line), {} });
+					return true;
+				}
+			}
+			else if (is_preprocessor) {
+				/* A preprocessor line in the middle of a declaration */
+				return false;
+			}
+		}
+
+		const auto first_field = out.size();
+		std::uint32_t line_tags = 0;
+
+		for (std::size_t i = first; i < line.size(); ++i) {
+			const auto c = line[i];
+
+			if (in_block_comment) {
+				const auto comment_end = line.find("*/", i);
+
+				if (comment_end == std::string_view::npos) {
+					break;
+				}
+
+				in_block_comment = false;
+				i = comment_end + 1;
+				continue;
+			}
+
+			if (in_literal) {
+				append(c);
+
+				if (c == '\\' && i + 1 < line.size()) {
+					append(line[++i]);
+				}
+				else if (c == in_literal) {
+					in_literal = 0;
+				}
+
+				continue;
+			}
+
+			if (!is_enum && !is_member_special(c)) {
+				/*
+					Copy the whole run of characters that cannot change the state at once.
+					Single spaces between words are part of the run.
+				*/
+
+				auto run_end = i + 1;
+
+				while (
+					run_end < line.size()
+					&& (
+						!is_member_special(line[run_end])
+						|| (line[run_end] == ' ' && run_end + 1 < line.size() && !is_space(line[run_end + 1]))
+					)
+				) {
+					++run_end;
+				}
+
+				const auto run = line.substr(i, run_end - i);
+
+				declaration.append(run.data(), run.size());
+				note_operator_keyword(run);
+
+				i = run_end - 1;
+				continue;
+			}
+
+			if (c == '/' && i + 1 < line.size()) {
+				const auto next = line[i + 1];
+
+				if (next == '/') {
+					if (!read_tags(line.substr(i + 2), line_tags)) {
+						return false;
+					}
+
+					break;
+				}
+
+				if (next == '*') {
+					in_block_comment = true;
+					++i;
+
+					if (is_enum) {
+						enumerator_complete = !declaration.empty();
+					}
+					else {
+						append_space();
+					}
+
+					continue;
+				}
+			}
+
+			const bool ok = is_enum ? feed_enum_char(c, out) : feed_member_char(line, i, out);
+
+			if (!ok) {
+				return false;
+			}
+		}
+
+		if (in_literal) {
+			return false;
+		}
+
+		if (is_enum) {
+			complete_enumerator(out);
+		}
+		else {
+			break_line();
+		}
+
+		if (line_tags != 0) {
+			for (auto i = first_field; i < out.size(); ++i) {
+				if (out[i].type == block_line_type::FIELD) {
+					out[i].tags |= line_tags;
+				}
+			}
+
+			if (!declaration.empty()) {
+				pending_tags |= line_tags;
+			}
+		}
+
+		return true;
+	}
+
+	/* Called at the end of the block. Fails if a declaration or a comment was left open. */
+
+	bool finish() const {
+		return !in_block_comment && declaration.empty();
+	}
+
+	/* Names of the tags found so far, in the order of their bits */
+
+	std::vector<std::string>& get_tag_names() {
+		return tag_names;
+	}
+};
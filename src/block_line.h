@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/*
+	A single line of a GEN INTROSPECTOR block, as it is kept in the model.
+*/
+
+enum class block_line_type : unsigned char {
+	/* Macros and whitespace-only lines, redirected to the output as they are */
+	INTACT,
+	FIELD
+};
+
+struct block_line {
+	block_line_type type = block_line_type::INTACT;
+
+	/* Bits of the tags from a trailing comment, indexing introspected_type::tag_names */
+	std::uint32_t tags = 0;
+
+	/* The intact line or the name of the field */
+	std::string text;
+
+	/* Empty for enumerators */
+	std::string field_type;
+};
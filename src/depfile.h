@@ -0,0 +1,143 @@
+#pragma once
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "spellbook.h"
+#include "generator_configuration.h"
+#include "generated_outputs.h"
+#include "scan_cache.h"
+
+/*
+	A Makefile-style dependency file, as understood by both Make and Ninja:
+
+	generated files: configuration files, scanned headers, walked directories
+
+	In a batch, all configurations make up a single rule, since they were all generated by a single command.
+
+	The directories are listed so that adding a header to header-directories triggers a run as well.
+	Since unchanged outputs are never touched, Ninja rules should set restat = 1.
+
+	Writing an output, its temporary file or the scan cache changes the modification time of the directory it is in,
+	so a directory that holds any of them is left out, or the generator would run on every build.
+*/
+
+/* Absolute and lexically normal, without a trailing separator */
+inline fs::path get_depfile_key(const fs::path& path) {
+	auto key = fs::absolute(path).lexically_normal();
+
+	if (key.has_parent_path() && key.filename().empty()) {
+		key = key.parent_path();
+	}
+
+	return key;
+}
+
+/* Compares whole components, so that "include2" is not within "include" */
+inline bool is_within_directory(const fs::path& directory_key, const fs::path& path_key) {
+	auto p = path_key.begin();
+
+	for (const auto& component : directory_key) {
+		if (p == path_key.end() || *p != component) {
+			return false;
+		}
+
+		++p;
+	}
+
+	return true;
+}
+
+inline std::string escape_depfile_path(const std::string& path) {
+	std::string escaped;
+	escaped.reserve(path.size());
+
+	for (const auto c : path) {
+		if (c == ' ' || c == '#') {
+			escaped += '\\';
+		}
+		else if (c == '$') {
+			escaped += '$';
+		}
+
+		escaped += c;
+	}
+
+	return escaped;
+}
+
+inline std::string make_depfile(
+	const std::vector<generator_configuration>& cfgs,
+	const std::vector<std::string>& configuration_file_input_paths,
+	const std::vector<written_outputs_summary>& summaries
+) {
+	std::string contents;
+
+	for (const auto& summary : summaries) {
+		for (const auto& o : summary.output_files) {
+			if (!contents.empty()) {
+				contents += ' ';
+			}
+
+			contents += escape_depfile_path(o);
+		}
+	}
+
+	contents += ':';
+
+	auto add_dependency = [&](const std::string& path) {
+		contents += " \\\n  ";
+		contents += escape_depfile_path(path);
+	};
+
+	for (const auto& path : configuration_file_input_paths) {
+		add_dependency(path);
+	}
+
+	std::unordered_set<std::string> headers;
+
+	for (const auto& summary : summaries) {
+		for (const auto& h : summary.header_files) {
+			if (headers.insert(fs::path(h).lexically_normal().string()).second) {
+				add_dependency(h);
+			}
+		}
+	}
+
+	/* Treated as already listed, so that they never are */
+	std::unordered_set<std::string> directories;
+
+	for (std::size_t c = 0; c < cfgs.size(); ++c) {
+		directories.insert(get_depfile_key(fs::path(get_scan_cache_path(cfgs[c].generated_file_path)).parent_path()).string());
+
+		for (const auto& o : summaries[c].output_files) {
+			directories.insert(get_depfile_key(fs::path(o).parent_path()).string());
+		}
+	}
+
+	for (const auto& cfg : cfgs) {
+		for (const auto& d : cfg.header_directories) {
+			if (directories.insert(get_depfile_key(d).string()).second) {
+				add_dependency(d);
+			}
+		}
+	}
+
+	for (std::size_t c = 0; c < cfgs.size(); ++c) {
+		for (const auto& d : cfgs[c].header_directories) {
+			const auto root = get_depfile_key(d);
+
+			for (const auto& h : summaries[c].header_files) {
+				const auto parent = fs::path(h).parent_path();
+				const auto parent_key = get_depfile_key(parent);
+
+				if (is_within_directory(root, parent_key) && directories.insert(parent_key.string()).second) {
+					add_dependency(parent.string());
+				}
+			}
+		}
+	}
+
+	contents += '\n';
+	return contents;
+}
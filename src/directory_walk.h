@@ -0,0 +1,278 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "spellbook.h"
+
+/*
+	Walks the header directories on many threads, one directory at a time.
+
+	The type of every entry comes from the directory stream itself,
+	so only symbolic links cost a stat. Linked directories are not entered, nor are their contents listed,
+	same as when every entry was checked with is_directory.
+
+	Files come out in the order that a single-threaded recursive walk would list them:
+	each directory remembers where among its files its subdirectories were met,
+	and the tree is flattened once it has been read completely.
+*/
+
+/*
+	'*' matches any characters but '/', "**" matches any characters, '?' matches any single character but '/'.
+	Patterns are short, so plain backtracking is enough.
+*/
+
+inline bool glob_match(const std::string_view pattern, const std::string_view text) {
+	if (pattern.empty()) {
+		return text.empty();
+	}
+
+	if (pattern.compare(0, 2, "**") == 0) {
+		auto rest = pattern.substr(2);
+
+		/* A "**" between slashes may stand for no directory at all */
+		if (!rest.empty() && rest[0] == '/' && glob_match(rest.substr(1), text)) {
+			return true;
+		}
+
+		for (std::size_t i = 0; i <= text.size(); ++i) {
+			if (glob_match(rest, text.substr(i))) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	if (pattern[0] == '*') {
+		const auto rest = pattern.substr(1);
+
+		for (std::size_t i = 0; i <= text.size(); ++i) {
+			if (glob_match(rest, text.substr(i))) {
+				return true;
+			}
+
+			if (i < text.size() && text[i] == '/') {
+				break;
+			}
+		}
+
+		return false;
+	}
+
+	if (text.empty()) {
+		return false;
+	}
+
+	if (pattern[0] == '?' ? text[0] == '/' : pattern[0] != text[0]) {
+		return false;
+	}
+
+	return glob_match(pattern.substr(1), text.substr(1));
+}
+
+/*
+	A pattern with a '/' is matched against the path relative to the walked directory, e.g. "external/tests",
+	one without is matched against the name alone, wherever the entry is, e.g. "build" or "*_generated.h".
+*/
+
+inline bool matches_any_glob(
+	const std::vector<std::string>& patterns,
+	const std::string_view name,
+	const std::string_view relative_path
+) {
+	for (const auto& p : patterns) {
+		if (glob_match(p, p.find('/') == std::string::npos ? name : relative_path)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+struct header_file_filter {
+	/* Empty means ".h" */
+	std::vector<std::string> extensions;
+
+	/* Files only. Empty means all files. */
+	std::vector<std::string> include_patterns;
+
+	/* Files and directories, whose contents are then never read */
+	std::vector<std::string> exclude_patterns;
+
+	bool has_header_extension(const std::string_view name) const {
+		const auto ends_with = [&](const std::string_view suffix) {
+			return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+		};
+
+		if (extensions.empty()) {
+			return ends_with(".h");
+		}
+
+		for (const auto& e : extensions) {
+			if (ends_with(e)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool is_excluded(const std::string_view name, const std::string_view relative_path) const {
+		return matches_any_glob(exclude_patterns, name, relative_path);
+	}
+
+	bool is_header(const std::string_view name, const std::string_view relative_path) const {
+		return
+			has_header_extension(name)
+			&& (include_patterns.empty() || matches_any_glob(include_patterns, name, relative_path))
+			&& !is_excluded(name, relative_path)
+		;
+	}
+};
+
+inline void walk_header_directory(
+	const std::string& root,
+	const header_file_filter& filter,
+	const std::size_t num_jobs,
+	std::vector<std::string>& header_files
+) {
+	struct walked_directory {
+		fs::path path;
+
+		/* Relative to the root, with '/' separators, empty for the root itself */
+		std::string relative_path;
+
+		std::vector<std::string> files;
+
+		/* The index of the subdirectory together with the number of files listed before it */
+		std::vector<std::pair<std::size_t, std::size_t>> subdirectories;
+	};
+
+	/* A deque, so that a directory being read stays in place while others are added */
+	std::deque<walked_directory> directories;
+	directories.push_back({ root, {}, {}, {} });
+
+	std::mutex lock;
+	std::condition_variable work_available;
+
+	std::vector<std::size_t> to_read = { 0 };
+	std::size_t num_being_read = 0;
+	std::exception_ptr error;
+
+	auto read_directory = [&](walked_directory& d, std::vector<walked_directory>& found) {
+		for (const auto& entry : fs::directory_iterator(d.path)) {
+			const auto& path = entry.path();
+			const auto name = path.filename().string();
+			const auto relative_path = d.relative_path.empty() ? name : d.relative_path + '/' + name;
+
+			if (entry.is_symlink()) {
+				if (!entry.is_directory() && filter.is_header(name, relative_path)) {
+					d.files.push_back(path.string());
+				}
+			}
+			else if (entry.is_directory()) {
+				if (!filter.is_excluded(name, relative_path)) {
+					d.subdirectories.emplace_back(found.size(), d.files.size());
+					found.push_back({ path, relative_path, {}, {} });
+				}
+			}
+			else if (filter.is_header(name, relative_path)) {
+				d.files.push_back(path.string());
+			}
+		}
+	};
+
+	auto worker = [&]() {
+		std::vector<walked_directory> found;
+		std::unique_lock<std::mutex> guard(lock);
+
+		while (true) {
+			work_available.wait(guard, [&]() {
+				return !to_read.empty() || num_being_read == 0 || error;
+			});
+
+			if (to_read.empty() || error) {
+				return;
+			}
+
+			const auto index = to_read.back();
+			to_read.pop_back();
+			++num_being_read;
+
+			auto& d = directories[index];
+			guard.unlock();
+
+			found.clear();
+
+			try {
+				read_directory(d, found);
+			}
+			catch (...) {
+				guard.lock();
+				error = error ? error : std::current_exception();
+				--num_being_read;
+				work_available.notify_all();
+				return;
+			}
+
+			guard.lock();
+
+			for (auto& s : d.subdirectories) {
+				s.first += directories.size();
+				to_read.push_back(s.first);
+			}
+
+			for (auto& f : found) {
+				directories.push_back(std::move(f));
+			}
+
+			--num_being_read;
+			work_available.notify_all();
+		}
+	};
+
+	{
+		std::vector<std::thread> threads;
+
+		for (std::size_t t = 1; t < num_jobs; ++t) {
+			threads.emplace_back(worker);
+		}
+
+		worker();
+
+		for (auto& t : threads) {
+			t.join();
+		}
+	}
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+
+	auto flatten = [&](auto& self, const walked_directory& d) -> void {
+		std::size_t next_file = 0;
+
+		auto add_files_until = [&](const std::size_t end) {
+			for (; next_file < end; ++next_file) {
+				header_files.push_back(d.files[next_file]);
+			}
+		};
+
+		for (const auto& s : d.subdirectories) {
+			add_files_until(s.second);
+			self(self, directories[s.first]);
+		}
+
+		add_files_until(d.files.size());
+	};
+
+	flatten(flatten, directories[0]);
+}
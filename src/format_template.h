@@ -0,0 +1,150 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/*
+	A format string from the configuration, parsed once into literal spans and argument slots.
+
+	Every '%' together with the character that follows it is an argument slot,
+	just as in typesafe_sprintf. Slots are filled with the arguments in order;
+	slots without a corresponding argument are left in the output verbatim,
+	and arguments without a corresponding slot are ignored.
+
+	Unlike typesafe_sprintf, substituted arguments are never scanned for slots again,
+	and no streams are involved, so an expansion costs exactly the size of its output.
+*/
+
+class format_template {
+	struct span {
+		std::size_t offset = 0;
+		std::size_t length = 0;
+	};
+
+	std::string source;
+
+	/* There is always exactly one more literal than there are slots */
+	std::vector<span> literals;
+
+	std::string_view get_literal(const std::size_t i) const {
+		return std::string_view(source).substr(literals[i].offset, literals[i].length);
+	}
+
+	std::string_view get_slot(const std::size_t i) const {
+		const auto slot_offset = literals[i].offset + literals[i].length;
+		return std::string_view(source).substr(slot_offset, literals[i + 1].offset - slot_offset);
+	}
+
+	template <class Out>
+	static void append_argument(Out& out, const std::string_view arg) {
+		out.append(arg.data(), arg.size());
+	}
+
+	template <class Out>
+	static void append_argument(Out& out, const char* const arg) {
+		append_argument(out, std::string_view(arg));
+	}
+
+	template <class Out>
+	static void append_argument(Out& out, const std::string& arg) {
+		append_argument(out, std::string_view(arg));
+	}
+
+	template <class Out, class T, class = std::enable_if_t<std::is_integral_v<T>>>
+	static void append_argument(Out& out, const T arg) {
+		char buffer[32];
+		const auto result = std::to_chars(buffer, buffer + sizeof(buffer), arg);
+		out.append(buffer, static_cast<std::size_t>(result.ptr - buffer));
+	}
+
+	/* Lets a large argument be generated straight into the output instead of being built up front */
+	template <class Out, class F, class = std::enable_if_t<std::is_invocable_v<const F&, Out&>>>
+	static void append_argument(Out& out, const F& generate) {
+		generate(out);
+	}
+
+	/* fill_rest(i) appends whatever goes into the slots left after the arguments */
+	template <class Out, class F, class... A>
+	void fill_slots(Out& out, F&& fill_rest, const A&... args) const {
+		const auto n = num_slots();
+		std::size_t i = 0;
+
+		const auto l0 = get_literal(0);
+		out.append(l0.data(), l0.size());
+
+		auto fill_slot = [&](const auto& arg) {
+			if (i < n) {
+				append_argument(out, arg);
+
+				const auto l = get_literal(++i);
+				out.append(l.data(), l.size());
+			}
+		};
+
+		(fill_slot(args), ...);
+
+		for (; i < n; ++i) {
+			fill_rest(i);
+
+			const auto l = get_literal(i + 1);
+			out.append(l.data(), l.size());
+		}
+	}
+
+public:
+	format_template() : literals(1) {}
+
+	explicit format_template(std::string f) : source(std::move(f)) {
+		std::size_t literal_begin = 0;
+
+		for (auto slot = source.find('%'); slot != std::string::npos; slot = source.find('%', literal_begin)) {
+			literals.push_back({ literal_begin, slot - literal_begin });
+			literal_begin = std::min(slot + 2, source.size());
+		}
+
+		literals.push_back({ literal_begin, source.size() - literal_begin });
+	}
+
+	bool empty() const {
+		return source.empty();
+	}
+
+	std::size_t num_slots() const {
+		return literals.size() - 1;
+	}
+
+	template <class Out, class... A>
+	void append_to(Out& out, const A&... args) const {
+		fill_slots(out, [&](const std::size_t i) {
+			const auto s = get_slot(i);
+			out.append(s.data(), s.size());
+		}, args...);
+	}
+
+	/*
+		For formats that use the last argument any number of times,
+		e.g. the fields of a type, once for every member function that goes over them.
+	*/
+
+	template <class Out, class... A>
+	void append_repeating_last_to(Out& out, const A&... args) const {
+		const auto& last = std::get<sizeof...(A) - 1>(std::forward_as_tuple(args...));
+
+		fill_slots(out, [&](std::size_t) {
+			append_argument(out, last);
+		}, args...);
+	}
+
+	template <class... A>
+	std::string operator()(const A&... args) const {
+		std::string result;
+		result.reserve(source.size());
+		append_to(result, args...);
+		return result;
+	}
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+	Contents of the generated files, when they are generated in memory.
+*/
+
+struct generated_outputs {
+	std::string generated_file;
+	std::string generated_specializations;
+	std::string generated_enums;
+
+	/* Paths and contents of per-header files in the sharded mode */
+	std::vector<std::pair<std::string, std::string>> shards;
+
+	/* Empty unless layout-report-path is set */
+	std::string layout_report;
+
+	/* Empty unless reflection-schema-path is set, see make_reflection_schema */
+	std::string reflection_schema;
+
+	/* Empty unless root-types is set, see prune_unreachable_types */
+	std::vector<std::string> pruned_types;
+	std::vector<std::string> unknown_root_types;
+};
+
+/*
+	What is reported after the generated files are written to disk.
+*/
+
+struct written_outputs_summary {
+	std::size_t generated_file_lines = 0;
+	std::size_t generated_enums_lines = 0;
+
+	/* Every header that was scanned and every file that was generated, e.g. for --depfile */
+	std::vector<std::string> header_files;
+	std::vector<std::string> output_files;
+
+	/* Empty unless root-types is set, see prune_unreachable_types */
+	std::vector<std::string> pruned_types;
+	std::vector<std::string> unknown_root_types;
+};
@@ -0,0 +1,596 @@
+#pragma once
+#include <algorithm>
+#include <exception>
+#include <cctype>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "spellbook.h"
+#include "introspected_type.h"
+#include "scan_cache.h"
+#include "parallel.h"
+#include "directory_walk.h"
+#include "generator_configuration.h"
+#include "type_emitters.h"
+#include "layout_report.h"
+#include "type_reachability.h"
+#include "structural_hash.h"
+#include "reflection_schema_writer.h"
+#include "output_writer.h"
+#include "run_stats.h"
+#include "generated_outputs.h"
+
+/*
+	The generation pipeline, split into stages so that it can be run repeatedly,
+	e.g. by the watch mode:
+
+	1. find_header_files - all headers from header-files and header-directories.
+	2. scan_headers - parses them into the format-independent model, possibly from cache.
+	3. make_scan_cache - gathers the scanned headers into the model, which is also the cache for the next run.
+	4. write_outputs - formats the model straight into the generated files, replacing only those that changed.
+	   generate_outputs does the same in memory.
+*/
+
+/* Headers are told apart by their normalized paths, e.g. a/./b.h and a/b.h are the same header */
+
+inline std::string get_header_key(const std::string& path) {
+	return fs::path(path).lexically_normal().string();
+}
+
+/*
+	A header listed twice, e.g. both in header-files and in one of header-directories,
+	would otherwise have its types gathered and emitted twice.
+	The first spelling of every header is kept.
+*/
+
+inline void remove_duplicate_headers(std::vector<std::string>& header_files) {
+	std::unordered_set<std::string> seen;
+
+	header_files.erase(
+		std::remove_if(
+			header_files.begin(),
+			header_files.end(),
+			[&](const std::string& h) { return !seen.insert(get_header_key(h)).second; }
+		),
+		header_files.end()
+	);
+}
+
+inline std::vector<std::string> find_header_files(
+	const generator_configuration& cfg,
+	const std::size_t num_jobs = get_default_num_jobs()
+) {
+	auto header_files = cfg.header_files;
+
+	for (const auto& dirpath : cfg.header_directories) {
+		walk_header_directory(dirpath, cfg.header_filter, num_jobs, header_files);
+	}
+
+	remove_duplicate_headers(header_files);
+	return header_files;
+}
+
+/*
+	Headers are scanned independently on all threads,
+	then merged in the original order so that the output does not depend on scheduling.
+	If any header fails to parse, the error of the first such header is rethrown.
+*/
+
+inline std::vector<scan_cache_entry> scan_headers(
+	const std::vector<std::string>& header_files,
+	const scan_cache& previous_scan_cache,
+	const std::size_t num_jobs,
+	run_stats* const stats = nullptr,
+	const bool allow_mapping = true
+) {
+	std::vector<scan_cache_entry> scanned_headers(header_files.size());
+	std::vector<std::exception_ptr> scan_errors(header_files.size());
+
+	parallel_for(num_jobs, header_files.size(), [&](const std::size_t i) {
+		try {
+			scanned_headers[i] = scan_header(header_files[i], previous_scan_cache, stats, allow_mapping);
+		}
+		catch (...) {
+			scan_errors[i] = std::current_exception();
+		}
+	});
+
+	for (const auto& e : scan_errors) {
+		if (e) {
+			std::rethrow_exception(e);
+		}
+	}
+
+	if (stats) {
+		stats->header_files += header_files.size();
+
+		for (const auto& h : scanned_headers) {
+			stats->annotated_types += h.types.size();
+
+			for (const auto& t : h.types) {
+				stats->fields += static_cast<std::size_t>(std::count_if(t.lines.begin(), t.lines.end(), [](const block_line& l) {
+					return l.type == block_line_type::FIELD;
+				}));
+			}
+		}
+	}
+
+	return scanned_headers;
+}
+
+inline scan_cache make_scan_cache(
+	const generator_configuration& cfg,
+	const std::vector<std::string>& header_files,
+	std::vector<scan_cache_entry> scanned_headers
+) {
+	scan_cache cache;
+	cache.beginning_line = cfg.beginning_line;
+	cache.ending_line = cfg.ending_line;
+
+	for (std::size_t i = 0; i < header_files.size(); ++i) {
+		cache.entries[header_files[i]] = std::move(scanned_headers[i]);
+	}
+
+	return cache;
+}
+
+/*
+	Calls f for every introspected type, in the order of header_files,
+	each header's types taken from the model produced by make_scan_cache.
+*/
+
+template <class F>
+void for_each_introspected_type(
+	const std::vector<std::string>& header_files,
+	const scan_cache& model,
+	F&& f
+) {
+	for (const auto& path : header_files) {
+		const auto found = model.entries.find(path);
+
+		if (found != model.entries.end()) {
+			for (const auto& t : found->second.types) {
+				f(t);
+			}
+		}
+	}
+}
+
+inline std::string make_forward_declarations(
+	const std::vector<std::string>& header_files,
+	const scan_cache& model
+) {
+	forward_declarations declarations;
+
+	for_each_introspected_type(header_files, model, [&](const introspected_type& t) {
+		declarations.add(t);
+	});
+
+	return declarations.make();
+}
+
+/*
+	Structural hashes take every type into account, not only those of a single shard,
+	so they are made once for the whole model, and only when structural-hash-format is set.
+*/
+
+inline std::unique_ptr<structural_hashes> make_structural_hashes_if_needed(
+	const generator_configuration& cfg,
+	const std::vector<std::string>& header_files,
+	const scan_cache& model
+) {
+	if (cfg.structural_hash_format.empty()) {
+		return nullptr;
+	}
+
+	return std::make_unique<structural_hashes>(make_structural_hashes(header_files, model));
+}
+
+/*
+	Each of these streams one of the generated files into any Out.
+*/
+
+template <class Out>
+void emit_generated_file(
+	const generator_configuration& cfg,
+	const std::vector<std::string>& header_files,
+	const scan_cache& model,
+	const std::string& forward_declarations,
+	Out& out
+) {
+	const auto hashes = make_structural_hashes_if_needed(cfg, header_files, model);
+
+	cfg.generated_file_format.append_to(
+		out,
+		forward_declarations,
+		[&](Out& introspectors) {
+			for_each_introspected_type(header_files, model, [&](const introspected_type& t) {
+				if (!t.is_enum()) {
+					emit_introspector(cfg, t, introspectors, hashes.get());
+				}
+			});
+		}
+	);
+}
+
+template <class Out>
+void emit_generated_specializations(
+	const generator_configuration& cfg,
+	const std::vector<std::string>& header_files,
+	const scan_cache& model,
+	Out& out
+) {
+	for_each_introspected_type(header_files, model, [&](const introspected_type& t) {
+		if (!t.is_enum()) {
+			emit_specialized_list(cfg, t, out);
+		}
+	});
+}
+
+template <class Out>
+void emit_generated_enums(
+	const generator_configuration& cfg,
+	const std::vector<std::string>& header_files,
+	const scan_cache& model,
+	const std::string& forward_declarations,
+	Out& out
+) {
+	out.append(forward_declarations.data(), forward_declarations.size());
+	out.append("\n", 1);
+
+	for_each_introspected_type(header_files, model, [&](const introspected_type& t) {
+		if (t.is_enum()) {
+			emit_enum(cfg, t, out);
+		}
+	});
+}
+
+inline std::string make_shard_name(
+	const std::string& header_path,
+	std::unordered_set<std::string>& used_names
+) {
+	auto name = fs::path(header_path).replace_extension().generic_string();
+
+	while (!name.empty() && (name[0] == '.' || name[0] == '/')) {
+		name.erase(name.begin());
+	}
+
+	for (auto& c : name) {
+		if (!std::isalnum(static_cast<unsigned char>(c))) {
+			c = '_';
+		}
+	}
+
+	auto unique_name = name;
+
+	for (int n = 2; !used_names.insert(unique_name).second; ++n) {
+		unique_name = name + "_" + std::to_string(n);
+	}
+
+	return unique_name;
+}
+
+/*
+	In the sharded mode, every header with introspected types gets up to three files
+	in sharded-output-directory, named after the header:
+
+	<name>.introspectors.h - the introspectors, meant to be included from within the generated file format;
+	<name>.specializations.h - the specialized lists;
+	<name>.enums.h - the enum functions, preceded by forward declarations of the header's own types.
+
+	The files at the usual output paths become umbrella headers that only include the shards.
+	Shards of untouched headers stay byte-identical,
+	so translation units that include only the shards they need are not rebuilt.
+*/
+
+inline generated_outputs generate_sharded_outputs(
+	const generator_configuration& cfg,
+	const std::vector<std::string>& header_files,
+	const scan_cache& model
+) {
+	const auto hashes = make_structural_hashes_if_needed(cfg, header_files, model);
+
+	forward_declarations all_declarations;
+	generated_outputs out;
+
+	std::string introspector_includes;
+	std::string specialization_includes;
+	std::string enum_includes;
+
+	std::unordered_set<std::string> used_names;
+
+	const auto shard_directory = fs::path(cfg.sharded_output_directory);
+
+	auto make_include = [](const std::string& umbrella_path, const fs::path& shard_path) {
+		const auto from = fs::absolute(umbrella_path).lexically_normal().parent_path();
+		const auto relative = fs::absolute(shard_path).lexically_normal().lexically_relative(from);
+
+		return "#include \"" + relative.generic_string() + "\"\n";
+	};
+
+	for (const auto& path : header_files) {
+		const auto found = model.entries.find(path);
+
+		if (found == model.entries.end() || found->second.types.empty()) {
+			continue;
+		}
+
+		forward_declarations declarations;
+
+		std::string introspectors;
+		std::string specializations;
+		std::string enums;
+
+		for (const auto& t : found->second.types) {
+			declarations.add(t);
+
+			if (t.is_enum()) {
+				emit_enum(cfg, t, enums);
+			}
+			else {
+				emit_introspector(cfg, t, introspectors, hashes.get());
+				emit_specialized_list(cfg, t, specializations);
+			}
+		}
+
+		all_declarations.merge(declarations);
+
+		const auto name = make_shard_name(path, used_names);
+
+		if (!introspectors.empty()) {
+			const auto shard_path = shard_directory / (name + ".introspectors.h");
+
+			out.shards.push_back({ shard_path.string(), std::move(introspectors) });
+			introspector_includes += make_include(cfg.generated_file_path, shard_path);
+		}
+
+		if (!specializations.empty()) {
+			const auto shard_path = shard_directory / (name + ".specializations.h");
+
+			out.shards.push_back({ shard_path.string(), std::move(specializations) });
+			specialization_includes += make_include(cfg.generated_specializations_path, shard_path);
+		}
+
+		if (!enums.empty()) {
+			const auto shard_path = shard_directory / (name + ".enums.h");
+
+			out.shards.push_back({ shard_path.string(), "#pragma once\n" + declarations.make() + "\n" + enums });
+			enum_includes += make_include(cfg.generated_enums_path, shard_path);
+		}
+	}
+
+	const auto forward_declarations = all_declarations.make();
+
+	out.generated_file = cfg.generated_file_format(
+		forward_declarations,
+		introspector_includes
+	);
+
+	out.generated_specializations = specialization_includes;
+	out.generated_enums = forward_declarations + "\n" + enum_includes;
+
+	return out;
+}
+
+inline generated_outputs generate_outputs(
+	const generator_configuration& cfg,
+	const std::vector<std::string>& header_files,
+	const scan_cache& model
+) {
+	generated_outputs out;
+
+	pruned_model pruned;
+
+	if (!cfg.root_types.empty()) {
+		pruned = prune_unreachable_types(cfg.root_types, header_files, model);
+		out.pruned_types = std::move(pruned.pruned_types);
+		out.unknown_root_types = std::move(pruned.unknown_root_types);
+	}
+
+	const auto& emitted_model = cfg.root_types.empty() ? model : pruned.model;
+
+	if (!cfg.sharded_output_directory.empty()) {
+		auto sharded = generate_sharded_outputs(cfg, header_files, emitted_model);
+
+		out.generated_file = std::move(sharded.generated_file);
+		out.generated_specializations = std::move(sharded.generated_specializations);
+		out.generated_enums = std::move(sharded.generated_enums);
+		out.shards = std::move(sharded.shards);
+	}
+	else {
+		const auto forward_declarations = make_forward_declarations(header_files, emitted_model);
+
+		emit_generated_file(cfg, header_files, emitted_model, forward_declarations, out.generated_file);
+		emit_generated_specializations(cfg, header_files, emitted_model, out.generated_specializations);
+		emit_generated_enums(cfg, header_files, emitted_model, forward_declarations, out.generated_enums);
+	}
+
+	if (!cfg.layout_report_path.empty()) {
+		emit_layout_report(cfg.layout_report_path, header_files, emitted_model, out.layout_report);
+	}
+
+	if (!cfg.reflection_schema_path.empty()) {
+		out.reflection_schema = make_reflection_schema(header_files, emitted_model);
+	}
+
+	return out;
+}
+
+/*
+	Streams the generated files to disk without building them in memory first.
+	The records of written files are kept in model.outputs,
+	so that unchanged files need not be read back on the next run.
+
+	With stats, formatting and writing are interleaved,
+	so the time of formatting is what remains after the writers' own time is subtracted.
+*/
+
+inline written_outputs_summary write_outputs(
+	const generator_configuration& cfg,
+	const std::vector<std::string>& header_files,
+	scan_cache& model,
+	run_stats* const stats = nullptr
+) {
+	written_outputs_summary summary;
+
+	pruned_model pruned;
+
+	if (!cfg.root_types.empty()) {
+		run_stats_scope scope(stats, run_phase::FORMAT, "prune_unreachable_types");
+
+		pruned = prune_unreachable_types(cfg.root_types, header_files, model);
+		summary.pruned_types = std::move(pruned.pruned_types);
+		summary.unknown_root_types = std::move(pruned.unknown_root_types);
+	}
+
+	/* model keeps every scanned type for the cache, while the outputs get only the reachable ones */
+	const auto& emitted_model = cfg.root_types.empty() ? model : pruned.model;
+
+	auto write_streamed = [&](const std::string& path, auto emit) {
+		const auto start = stats ? run_stats::clock::now() : run_stats::clock::time_point();
+
+		streaming_file_writer out(path, stats);
+		emit(out);
+		out.commit(model.outputs[path]);
+
+		if (stats) {
+			const auto end = run_stats::clock::now();
+
+			stats->add_time(run_phase::FORMAT, end - start - out.get_io_time());
+			stats->add_trace_event("write_output", path, start, end);
+		}
+
+		return out.get_num_lines();
+	};
+
+	/* Files that do not depend on whether the output is sharded */
+	auto write_optional_outputs = [&]() {
+		if (!cfg.layout_report_path.empty()) {
+			write_streamed(cfg.layout_report_path, [&](streaming_file_writer& out) {
+				emit_layout_report(cfg.layout_report_path, header_files, emitted_model, out);
+			});
+
+			summary.output_files.push_back(cfg.layout_report_path);
+		}
+
+		if (!cfg.reflection_schema_path.empty()) {
+			const auto& path = cfg.reflection_schema_path;
+
+			const auto schema = [&]() {
+				run_stats_scope scope(stats, run_phase::FORMAT, "make_reflection_schema");
+				return make_reflection_schema(header_files, emitted_model);
+			}();
+
+			streaming_file_writer out(path, stats, std::ios::out | std::ios::binary);
+			out += schema;
+			out.commit(model.outputs[path]);
+
+			summary.output_files.push_back(path);
+		}
+	};
+
+	if (!cfg.sharded_output_directory.empty()) {
+		const auto outputs = [&]() {
+			run_stats_scope scope(stats, run_phase::FORMAT, "generate_sharded_outputs");
+			return generate_sharded_outputs(cfg, header_files, emitted_model);
+		}();
+
+		guarded_create_file(cfg.generated_file_path, outputs.generated_file, model.outputs[cfg.generated_file_path], stats);
+		guarded_create_file(cfg.generated_specializations_path, outputs.generated_specializations, model.outputs[cfg.generated_specializations_path], stats);
+		guarded_create_file(cfg.generated_enums_path, outputs.generated_enums, model.outputs[cfg.generated_enums_path], stats);
+
+		summary.output_files = {
+			cfg.generated_file_path,
+			cfg.generated_specializations_path,
+			cfg.generated_enums_path
+		};
+
+		fs::create_directories(cfg.sharded_output_directory);
+
+		std::unordered_set<std::string> written;
+		std::vector<std::string> shards;
+
+		for (const auto& s : outputs.shards) {
+			guarded_create_file(s.first, s.second, model.outputs[s.first], stats);
+			summary.output_files.push_back(s.first);
+			written.insert(s.first);
+			shards.push_back(s.first);
+		}
+
+		/*
+			Remove the shards of headers that no longer have any introspected types,
+			but only those that this configuration wrote itself.
+		*/
+
+		for (const auto& previous : model.shards) {
+			if (written.count(previous) == 0) {
+				std::error_code err;
+				fs::remove(previous, err);
+				model.outputs.erase(previous);
+			}
+		}
+
+		model.shards = std::move(shards);
+
+		summary.generated_file_lines = static_cast<std::size_t>(std::count(outputs.generated_file.begin(), outputs.generated_file.end(), '\n'));
+		summary.generated_enums_lines = static_cast<std::size_t>(std::count(outputs.generated_enums.begin(), outputs.generated_enums.end(), '\n'));
+
+		write_optional_outputs();
+		return summary;
+	}
+
+	const auto forward_declarations = [&]() {
+		run_stats_scope scope(stats, run_phase::FORMAT, "make_forward_declarations");
+		return make_forward_declarations(header_files, emitted_model);
+	}();
+
+	summary.generated_file_lines = write_streamed(cfg.generated_file_path, [&](streaming_file_writer& out) {
+		emit_generated_file(cfg, header_files, emitted_model, forward_declarations, out);
+	});
+
+	write_streamed(cfg.generated_specializations_path, [&](streaming_file_writer& out) {
+		emit_generated_specializations(cfg, header_files, emitted_model, out);
+	});
+
+	summary.generated_enums_lines = write_streamed(cfg.generated_enums_path, [&](streaming_file_writer& out) {
+		emit_generated_enums(cfg, header_files, emitted_model, forward_declarations, out);
+	});
+
+	summary.output_files = {
+		cfg.generated_file_path,
+		cfg.generated_specializations_path,
+		cfg.generated_enums_path
+	};
+
+	write_optional_outputs();
+	return summary;
+}
+
+/*
+	In a batch, the header may belong to any of the configurations,
+	so the error ends up in the generated files of all of them.
+*/
+
+inline void report_parse_error(
+	const std::vector<generator_configuration>& cfgs,
+	const header_parse_error& err
+) {
+	const auto error_contents = std::string(err.what());
+
+	for (const auto& cfg : cfgs) {
+		create_text_file(cfg.generated_file_path, "#error " + error_contents);
+	}
+
+	std::cout << "------------\nIntrospector-generator run failed." << std::endl;
+	std::cout << error_contents << std::endl;
+	std::cout << "------------\n";
+}
+
+inline void report_parse_error(
+	const generator_configuration& cfg,
+	const header_parse_error& err
+) {
+	report_parse_error(std::vector<generator_configuration> { cfg }, err);
+}
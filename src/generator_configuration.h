@@ -0,0 +1,189 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "spellbook.h"
+#include "format_template.h"
+#include "directory_walk.h"
+
+struct generator_configuration {
+	std::string beginning_line;
+	std::string ending_line;
+	std::vector<std::string> header_directories;
+	std::vector<std::string> header_files;
+	std::string generated_file_path;
+	std::string generated_enums_path;
+	std::string generated_specializations_path;
+	format_template introspector_field_format;
+	format_template introspector_body_format;
+	format_template specialized_list_format;
+	format_template enum_field_format;
+	format_template enum_introspector_body_format;
+	format_template enum_arg_format;
+	format_template enum_to_args_body_format;
+	format_template generated_file_format;
+
+	/* Optional. When set, every header gets its own generated files there, see generate_sharded_outputs. */
+	std::string sharded_output_directory;
+
+	/* Optional. When set, emitted after every introspect_body, see emit_field_metadata. */
+	format_template introspector_metadata_format;
+	format_template introspector_metadata_field_format;
+
+	/* Optional. When set, emitted after every introspect_body, see emit_serializer. */
+	format_template serializer_format;
+	format_template serializer_field_format;
+
+	/* Optional. When set, emitted after every enum_to_args_body, see emit_enum_lookup. */
+	format_template enum_lookup_format;
+
+	/* Optional. When set, a translation unit that prints the layouts of the types is written there, see emit_layout_report. */
+	std::string layout_report_path;
+
+	/* Optional. Every filter, e.g. "net" or "!nosave", gets its own introspect body, see emit_tagged_introspector. */
+	std::vector<std::string> tagged_introspectors;
+	format_template tagged_introspector_body_format;
+
+	/* Optional. When set, emitted after every introspect_body, see emit_comparison. */
+	format_template comparison_format;
+	format_template comparison_field_format;
+
+	/* Optional. When set, emitted after every introspect_body, see emit_soa. */
+	format_template soa_format;
+	format_template soa_field_format;
+
+	/* Optional. Which files in header-directories are scanned, see walk_header_directory. */
+	header_file_filter header_filter;
+
+	/* Optional. When set, only the types reachable from these are generated, see prune_unreachable_types. */
+	std::vector<std::string> root_types;
+
+	/* Optional. When set, a binary schema of all the types is written there, see reflection_schema.h. */
+	std::string reflection_schema_path;
+
+	/* Optional. When set, emitted after every introspect_body, see emit_structural_hash. */
+	format_template structural_hash_format;
+	format_template structural_hash_field_format;
+};
+
+/*
+	Throws if the configuration is empty or malformed.
+*/
+
+inline generator_configuration make_generator_configuration(const std::vector<std::string>& cfg) {
+	if (cfg.size() == 0) {
+		throw std::exception();
+	}
+
+	const auto lines_per_prop = break_lines_by_properties(
+		cfg,
+		{
+			"beginning-line:",
+			"ending-line:",
+			"header-directories:",
+			"header-files:",
+			"generated-file-path:",
+			"generated-enums-path:",
+			"generated-specializations-path:",
+			"introspector-field-format:",
+			"introspector-body-format:",
+			"specialized-list-format:",
+			"enum-field-format:",
+			"enum-introspector-body-format:",
+			"enum-arg-format:",
+			"enum-to-args-body-format:",
+			"generated-file-format:"
+		},
+		{
+			"sharded-output-directory:",
+			"introspector-metadata-format:",
+			"introspector-metadata-field-format:",
+			"enum-lookup-format:",
+			"serializer-format:",
+			"serializer-field-format:",
+			"layout-report-path:",
+			"tagged-introspectors:",
+			"tagged-introspector-body-format:",
+			"comparison-format:",
+			"comparison-field-format:",
+			"soa-format:",
+			"soa-field-format:",
+			"header-extensions:",
+			"header-include-patterns:",
+			"header-exclude-patterns:",
+			"root-types:",
+			"reflection-schema-path:",
+			"structural-hash-format:",
+			"structural-hash-field-format:"
+		}
+	);
+
+	generator_configuration out;
+
+	std::size_t i = 0u;
+
+	out.beginning_line = lines_per_prop.at(i++).at(0);
+	out.ending_line = lines_per_prop.at(i++).at(0);
+	out.header_directories = lines_per_prop.at(i++);
+	out.header_files = lines_per_prop.at(i++);
+	out.generated_file_path = lines_per_prop.at(i++).at(0);
+	out.generated_enums_path = lines_per_prop.at(i++).at(0);
+	out.generated_specializations_path = lines_per_prop.at(i++).at(0);
+	out.introspector_field_format = format_template(lines_to_string(lines_per_prop[i++]));
+	out.introspector_body_format = format_template(lines_to_string(lines_per_prop[i++]));
+	out.specialized_list_format = format_template(lines_to_string(lines_per_prop[i++]));
+	out.enum_field_format = format_template(lines_to_string(lines_per_prop[i++]));
+	out.enum_introspector_body_format = format_template(lines_to_string(lines_per_prop[i++]));
+	out.enum_arg_format = format_template(lines_to_string(lines_per_prop[i++]));
+	out.enum_to_args_body_format = format_template(lines_to_string(lines_per_prop[i++]));
+	out.generated_file_format = format_template(lines_to_string(lines_per_prop[i++]));
+
+	if (const auto& sharded = lines_per_prop[i++]; !sharded.empty()) {
+		out.sharded_output_directory = sharded[0];
+	}
+
+	out.introspector_metadata_format = format_template(lines_to_string(lines_per_prop[i++]));
+
+	{
+		/* Formatted fields are separated by commas, so the format is a single line without a line break */
+		auto metadata_field_format = lines_to_string(lines_per_prop[i++]);
+
+		if (!metadata_field_format.empty()) {
+			metadata_field_format.pop_back();
+		}
+
+		out.introspector_metadata_field_format = format_template(std::move(metadata_field_format));
+	}
+
+	out.enum_lookup_format = format_template(lines_to_string(lines_per_prop[i++]));
+	out.serializer_format = format_template(lines_to_string(lines_per_prop[i++]));
+	out.serializer_field_format = format_template(lines_to_string(lines_per_prop[i++]));
+
+	if (const auto& layout_report = lines_per_prop[i++]; !layout_report.empty()) {
+		out.layout_report_path = layout_report[0];
+	}
+
+	out.tagged_introspectors = lines_per_prop[i++];
+	out.tagged_introspector_body_format = format_template(lines_to_string(lines_per_prop[i++]));
+	out.comparison_format = format_template(lines_to_string(lines_per_prop[i++]));
+	out.comparison_field_format = format_template(lines_to_string(lines_per_prop[i++]));
+	out.soa_format = format_template(lines_to_string(lines_per_prop[i++]));
+	out.soa_field_format = format_template(lines_to_string(lines_per_prop[i++]));
+	out.header_filter.extensions = lines_per_prop[i++];
+	out.header_filter.include_patterns = lines_per_prop[i++];
+	out.header_filter.exclude_patterns = lines_per_prop[i++];
+	out.root_types = lines_per_prop[i++];
+
+	if (const auto& reflection_schema = lines_per_prop[i++]; !reflection_schema.empty()) {
+		out.reflection_schema_path = reflection_schema[0];
+	}
+
+	out.structural_hash_format = format_template(lines_to_string(lines_per_prop[i++]));
+	out.structural_hash_field_format = format_template(lines_to_string(lines_per_prop[i++]));
+
+	return out;
+}
+
+inline generator_configuration read_generator_configuration(const std::string& configuration_file_input_path) {
+	return make_generator_configuration(get_file_lines(configuration_file_input_path));
+}
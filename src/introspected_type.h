@@ -0,0 +1,194 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <vector>
+#include <utility>
+
+#include "spellbook.h"
+#include "marker_search.h"
+#include "run_stats.h"
+#include "block_line.h"
+#include "block_lexer.h"
+
+/*
+	Everything the generator needs to know about a single GEN INTROSPECTOR block,
+	independently of the output formats.
+	Parsed headers are cached and merged in terms of this model.
+*/
+
+struct introspected_type {
+	std::string struct_or_class_or_enum;
+	std::string type_name_without_templates;
+	std::vector<std::pair<std::string, std::string>> template_arguments;
+	std::vector<block_line> lines;
+
+	/* Tags used by the fields, see block_line::tags */
+	std::vector<std::string> tag_names;
+
+	bool is_enum() const {
+		return struct_or_class_or_enum == "enum" || struct_or_class_or_enum == "enum class";
+	}
+};
+
+using introspected_types = std::vector<introspected_type>;
+
+class header_parse_error : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+/*
+	The whole header is first searched for the beginning marker,
+	so headers without annotations are rejected without ever being split into lines.
+	Only the lines inside GEN INTROSPECTOR blocks are visited one by one,
+	and only those are ever copied.
+
+	Lines are counted from 0 and split exactly like with std::getline.
+	With stats, the time spent searching for markers is told apart from the rest of the parse.
+*/
+
+inline introspected_types parse_introspected_types(
+	const std::string_view contents,
+	const std::string& path,
+	const std::string& beginning_line,
+	const std::string& ending_line,
+	run_stats* const stats = nullptr
+) {
+	introspected_types result;
+
+	const auto parse_start = stats ? run_stats::clock::now() : run_stats::clock::time_point();
+	run_stats::clock::duration marker_scan_time = {};
+
+	const auto find_beginning = [&](const std::size_t from) {
+		if (stats == nullptr) {
+			return find_marker(contents, beginning_line, from);
+		}
+
+		const auto start = run_stats::clock::now();
+		const auto found = find_marker(contents, beginning_line, from);
+		marker_scan_time += run_stats::clock::now() - start;
+
+		return found;
+	};
+
+	size_t current_line = 0;
+	size_t current_line_offset = 0;
+	size_t next_line_offset = 0;
+	std::string_view current_line_contents;
+
+	const auto errcheck = [&](const bool flag) {
+		if (!flag) {
+			throw header_parse_error(typesafe_sprintf(
+				"A problem in line %x in file %x:\n%x\n",
+				current_line,
+				path,
+				current_line_contents
+			));
+		}
+	};
+
+	const auto read_line_at = [&](const std::size_t offset) {
+		auto end = contents.find('\n', offset);
+
+		if (end == std::string_view::npos) {
+			end = contents.size();
+		}
+
+		current_line_contents = contents.substr(offset, end - offset);
+		current_line_offset = offset;
+		next_line_offset = end + 1;
+	};
+
+	for (
+		auto found_gen_begin = find_beginning(0);
+		found_gen_begin != std::string_view::npos;
+		found_gen_begin = find_beginning(next_line_offset)
+	) {
+		{
+			const auto line_begin = contents.rfind('\n', found_gen_begin);
+			const auto line_offset = line_begin == std::string_view::npos ? 0 : line_begin + 1;
+
+			current_line += std::count(
+				contents.begin() + current_line_offset,
+				contents.begin() + line_offset,
+				'\n'
+			);
+
+			read_line_at(line_offset);
+		}
+
+		{
+			const auto after_gen = std::string(contents.substr(
+				found_gen_begin + beginning_line.length(),
+				next_line_offset - 1 - found_gen_begin - beginning_line.length()
+			));
+			std::istringstream in(after_gen);
+
+			introspected_type new_type;
+			auto& struct_or_class_or_enum = new_type.struct_or_class_or_enum;
+			auto& type_name_without_templates = new_type.type_name_without_templates;
+
+			in >> struct_or_class_or_enum;
+
+			const bool is_enum =
+				struct_or_class_or_enum == "enum"
+				;
+
+			errcheck(
+				struct_or_class_or_enum == "struct"
+				|| struct_or_class_or_enum == "class"
+				|| is_enum
+			);
+
+			if (is_enum) {
+				in >> type_name_without_templates;
+
+				if (type_name_without_templates == "class") {
+					struct_or_class_or_enum = "enum class";
+					in >> type_name_without_templates;
+				}
+			}
+			else {
+				in >> type_name_without_templates;
+			}
+
+			std::string template_arg_type;
+			std::string template_arg_name;
+
+			while (in >> template_arg_type && in >> template_arg_name) {
+				new_type.template_arguments.push_back({ template_arg_type, template_arg_name });
+			}
+
+			block_lexer lexer(is_enum);
+
+			while (true) {
+				++current_line;
+				current_line_contents = {};
+				errcheck(next_line_offset < contents.size());
+
+				read_line_at(next_line_offset);
+
+				if (current_line_contents.find(ending_line) != std::string_view::npos) {
+					errcheck(lexer.finish());
+					new_type.tag_names = std::move(lexer.get_tag_names());
+					break;
+				}
+
+				errcheck(lexer.feed(current_line_contents, new_type.lines));
+			}
+
+			result.emplace_back(std::move(new_type));
+		}
+	}
+
+	if (stats) {
+		stats->add_time(run_phase::MARKER_SCAN, marker_scan_time);
+		stats->add_time(run_phase::FIELD_PARSE, run_stats::clock::now() - parse_start - marker_scan_time);
+	}
+
+	return result;
+}
@@ -0,0 +1,237 @@
+#include <exception>
+#include <unordered_map>
+
+#include "introspector_generator.h"
+#include "generator.h"
+
+namespace introspector_generator {
+	static std::size_t resolve_num_jobs(const std::size_t num_jobs) {
+		return num_jobs == 0 ? get_default_num_jobs() : num_jobs;
+	}
+
+	generator_configuration parse_configuration(const std::string_view contents) {
+		return make_generator_configuration(get_string_lines(contents));
+	}
+
+	generator_configuration read_configuration(const std::string& configuration_file_input_path) {
+		return read_generator_configuration(configuration_file_input_path);
+	}
+
+	introspected_types parse_header(
+		const generator_configuration& cfg,
+		const header_buffer& header
+	) {
+		return parse_introspected_types(
+			header.contents,
+			header.path,
+			cfg.beginning_line,
+			cfg.ending_line
+		);
+	}
+
+	generated_outputs generate(
+		const generator_configuration& cfg,
+		const std::vector<header_buffer>& headers,
+		const std::size_t num_jobs
+	) {
+		std::vector<std::string> header_paths;
+		std::vector<scan_cache_entry> parsed_headers(headers.size());
+		std::vector<std::exception_ptr> parse_errors(headers.size());
+
+		header_paths.reserve(headers.size());
+
+		for (const auto& h : headers) {
+			header_paths.push_back(h.path);
+		}
+
+		parallel_for(resolve_num_jobs(num_jobs), headers.size(), [&](const std::size_t i) {
+			try {
+				parsed_headers[i].types = parse_header(cfg, headers[i]);
+			}
+			catch (...) {
+				parse_errors[i] = std::current_exception();
+			}
+		});
+
+		for (const auto& e : parse_errors) {
+			if (e) {
+				std::rethrow_exception(e);
+			}
+		}
+
+		const auto model = make_scan_cache(cfg, header_paths, std::move(parsed_headers));
+
+		return generate_outputs(cfg, header_paths, model);
+	}
+
+	written_outputs_summary generate_files(
+		const generator_configuration& cfg,
+		const std::size_t num_jobs,
+		run_stats* const stats
+	) {
+		return std::move(generate_files_batch({ cfg }, num_jobs, stats)[0]);
+	}
+
+	std::vector<written_outputs_summary> generate_files_batch(
+		const std::vector<generator_configuration>& cfgs,
+		const std::size_t num_jobs,
+		run_stats* const stats
+	) {
+		const auto jobs = resolve_num_jobs(num_jobs);
+		const auto n = cfgs.size();
+
+		std::vector<std::vector<std::string>> header_files(n);
+		std::vector<scan_cache> previous_scan_caches(n);
+
+		{
+			run_stats_scope scope(stats, run_phase::DIRECTORY_WALK, "find_header_files");
+
+			/* Modules often walk the same directories with the same filters */
+			std::unordered_map<std::string, std::vector<std::string>> walks;
+
+			for (std::size_t c = 0; c < n; ++c) {
+				const auto& cfg = cfgs[c];
+				const auto& filter = cfg.header_filter;
+
+				header_files[c] = cfg.header_files;
+
+				for (const auto& dirpath : cfg.header_directories) {
+					auto key = fs::path(dirpath).lexically_normal().string();
+
+					for (const auto* list : { &filter.extensions, &filter.include_patterns, &filter.exclude_patterns }) {
+						key += '\n';
+
+						for (const auto& p : *list) {
+							(key += p) += '\t';
+						}
+					}
+
+					auto found = walks.find(key);
+
+					if (found == walks.end()) {
+						found = walks.emplace(std::move(key), std::vector<std::string>()).first;
+						walk_header_directory(dirpath, filter, jobs, found->second);
+					}
+
+					header_files[c].insert(header_files[c].end(), found->second.begin(), found->second.end());
+				}
+
+				remove_duplicate_headers(header_files[c]);
+			}
+		}
+
+		{
+			run_stats_scope scope(stats, run_phase::CACHE_LOAD, "load_scan_cache");
+
+			for (std::size_t c = 0; c < n; ++c) {
+				previous_scan_caches[c] = load_scan_cache(get_scan_cache_path(cfgs[c].generated_file_path), cfgs[c].beginning_line, cfgs[c].ending_line);
+			}
+		}
+
+		/*
+			Every distinct pair of markers gets a single scan of the union of the headers of its configurations.
+			Headers are told apart by their normalized paths, while every configuration keeps its own spelling of them.
+		*/
+
+		std::vector<scan_cache> next_scan_caches(n);
+		std::vector<bool> scanned(n, false);
+
+		const auto scan_start = run_stats::clock::now();
+
+		for (std::size_t first = 0; first < n; ++first) {
+			if (scanned[first]) {
+				continue;
+			}
+
+			std::vector<std::size_t> group;
+
+			for (std::size_t c = first; c < n; ++c) {
+				if (!scanned[c] && cfgs[c].beginning_line == cfgs[first].beginning_line && cfgs[c].ending_line == cfgs[first].ending_line) {
+					group.push_back(c);
+					scanned[c] = true;
+				}
+			}
+
+			std::vector<std::string> unique_headers;
+			std::unordered_map<std::string, std::size_t> unique_index;
+
+			/* Per configuration of the group, the unique header behind each of its headers */
+			std::vector<std::vector<std::size_t>> indices(group.size());
+
+			for (std::size_t g = 0; g < group.size(); ++g) {
+				for (const auto& h : header_files[group[g]]) {
+					const auto found = unique_index.emplace(get_header_key(h), unique_headers.size());
+
+					if (found.second) {
+						unique_headers.push_back(h);
+					}
+
+					indices[g].push_back(found.first->second);
+				}
+			}
+
+			scan_cache previous;
+			previous.beginning_line = cfgs[first].beginning_line;
+			previous.ending_line = cfgs[first].ending_line;
+
+			for (const auto c : group) {
+				for (auto& e : previous_scan_caches[c].entries) {
+					const auto found = unique_index.find(get_header_key(e.first));
+
+					if (found != unique_index.end()) {
+						previous.entries.emplace(unique_headers[found->second], std::move(e.second));
+					}
+				}
+			}
+
+			auto scanned_headers = scan_headers(unique_headers, previous, jobs, stats);
+
+			/* The last configuration to use a scanned header takes it instead of a copy */
+			std::vector<std::size_t> uses_left(unique_headers.size(), 0);
+
+			for (const auto& i : indices) {
+				for (const auto u : i) {
+					++uses_left[u];
+				}
+			}
+
+			for (std::size_t g = 0; g < group.size(); ++g) {
+				const auto c = group[g];
+
+				std::vector<scan_cache_entry> entries;
+				entries.reserve(indices[g].size());
+
+				for (const auto u : indices[g]) {
+					if (--uses_left[u] == 0) {
+						entries.push_back(std::move(scanned_headers[u]));
+					}
+					else {
+						entries.push_back(scanned_headers[u]);
+					}
+				}
+
+				next_scan_caches[c] = make_scan_cache(cfgs[c], header_files[c], std::move(entries));
+				next_scan_caches[c].outputs = std::move(previous_scan_caches[c].outputs);
+				next_scan_caches[c].shards = std::move(previous_scan_caches[c].shards);
+			}
+		}
+
+		if (stats) {
+			stats->add_trace_event("scan_headers", "", scan_start, run_stats::clock::now());
+		}
+
+		std::vector<written_outputs_summary> summaries(n);
+
+		for (std::size_t c = 0; c < n; ++c) {
+			summaries[c] = write_outputs(cfgs[c], header_files[c], next_scan_caches[c], stats);
+			summaries[c].header_files = header_files[c];
+
+			{
+				run_stats_scope scope(stats, run_phase::CACHE_SAVE, "save_scan_cache");
+				save_scan_cache(get_scan_cache_path(cfgs[c].generated_file_path), next_scan_caches[c]);
+			}
+		}
+
+		return summaries;
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "generator_configuration.h"
+#include "introspected_type.h"
+#include "generated_outputs.h"
+#include "run_stats.h"
+
+/*
+	The in-process interface of the generator, built as the Introspector-generator-lib library.
+	Introspector-generator itself is a command-line front-end over these functions.
+
+	Configuration errors throw std::exception, as they always did.
+	Bad syntax in a header throws header_parse_error, naming the header and the offending line.
+	num_jobs of 0 means as many threads as the hardware has.
+*/
+
+namespace introspector_generator {
+	struct header_buffer {
+		/*
+			Identifies the header in error messages and, in the sharded mode, names its shards.
+			Should be unique among the headers of a single call.
+		*/
+
+		std::string path;
+		std::string_view contents;
+	};
+
+	generator_configuration parse_configuration(std::string_view contents);
+	generator_configuration read_configuration(const std::string& configuration_file_input_path);
+
+	introspected_types parse_header(
+		const generator_configuration& cfg,
+		const header_buffer& header
+	);
+
+	/*
+		Generates the contents of all outputs from headers that are already in memory.
+		The types are taken in the order of the given headers.
+		Nothing is read from or written to disk.
+	*/
+
+	generated_outputs generate(
+		const generator_configuration& cfg,
+		const std::vector<header_buffer>& headers,
+		std::size_t num_jobs = 0
+	);
+
+	/*
+		Does what a single run of the command-line tool does:
+		finds the headers from the configuration, scans them with the help of the scan cache,
+		then writes the generated files whose contents changed and saves the scan cache.
+		The summary lists the scanned headers and the generated files.
+	*/
+
+	written_outputs_summary generate_files(
+		const generator_configuration& cfg,
+		std::size_t num_jobs = 0,
+		run_stats* stats = nullptr
+	);
+
+	/*
+		Does what generate_files does for every configuration, with a single scan of the headers they share:
+		a header found by several configurations with the same markers is read and parsed only once.
+		Each configuration still gets its own outputs and its own scan cache.
+		Returns the summaries in the order of the configurations.
+	*/
+
+	std::vector<written_outputs_summary> generate_files_batch(
+		const std::vector<generator_configuration>& cfgs,
+		std::size_t num_jobs = 0,
+		run_stats* stats = nullptr
+	);
+}
@@ -0,0 +1,219 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "spellbook.h"
+#include "introspected_type.h"
+#include "scan_cache.h"
+#include "type_emitters.h"
+
+/*
+	The layout report is a standalone translation unit.
+	Compiled against the introspected headers and run, it prints sizeof, alignof,
+	and the offset, size, alignment and preceding padding of every field
+	of every introspected struct and class, together with an order of fields
+	that would need the least padding and how many fields would then straddle a cache line.
+
+	Offsets of private fields need member pointers to private fields,
+	which are obtained through explicit instantiations, where access is not checked.
+	That is also why the report needs no changes in the introspected types.
+
+	Templates cannot be measured without their arguments, so they are skipped, and so are enums.
+*/
+
+inline const char* const layout_report_preamble = R"(
+namespace {
+	/* Names of private members may be used in explicit instantiations, which is how their member pointers are obtained */
+	template <class Tag, auto Member>
+	struct layout_expose {
+		friend constexpr auto get_member(Tag) {
+			return Member;
+		}
+	};
+
+	struct field_layout {
+		const char* name;
+		std::size_t offset;
+		std::size_t size;
+		std::size_t alignment;
+	};
+
+	template <class T, class C, class F>
+	field_layout make_field_layout(const char* const name, F C::* const member) {
+		alignas(T) static unsigned char storage[sizeof(T)];
+
+		const auto& object = *reinterpret_cast<const T*>(storage);
+		const auto offset = reinterpret_cast<const unsigned char*>(&(object.*member)) - storage;
+
+		return { name, static_cast<std::size_t>(offset), sizeof(F), alignof(F) };
+	}
+
+	constexpr std::size_t cache_line_size = 64;
+
+	std::size_t align_up(const std::size_t n, const std::size_t alignment) {
+		return (n + alignment - 1) / alignment * alignment;
+	}
+
+	std::size_t count_cache_line_splits(const std::vector<field_layout>& fields) {
+		std::size_t splits = 0;
+
+		for (const auto& f : fields) {
+			if (f.size > 0 && f.size <= cache_line_size && f.offset / cache_line_size != (f.offset + f.size - 1) / cache_line_size) {
+				++splits;
+			}
+		}
+
+		return splits;
+	}
+
+	std::size_t total_padding = 0;
+	std::size_t total_savings = 0;
+
+	void report(const char* const type_name, const std::size_t size, const std::size_t alignment, std::vector<field_layout> fields) {
+		std::stable_sort(fields.begin(), fields.end(), [](const field_layout& a, const field_layout& b) {
+			return a.offset < b.offset;
+		});
+
+		std::printf("%s: size %zu, align %zu\n", type_name, size, alignment);
+		std::printf("  %8s %8s %8s %8s  %s\n", "offset", "size", "align", "padding", "field");
+
+		/* Whatever precedes the first field, e.g. a base or a vtable pointer, is not padding of the fields */
+		const std::size_t first_offset = fields.empty() ? 0 : fields.front().offset;
+
+		std::size_t end = first_offset;
+		std::size_t padding = 0;
+
+		for (const auto& f : fields) {
+			const auto before = f.offset > end ? f.offset - end : 0;
+
+			padding += before;
+			end = std::max(end, f.offset + f.size);
+
+			std::printf("  %8zu %8zu %8zu %8zu  %s\n", f.offset, f.size, f.alignment, before, f.name);
+		}
+
+		const auto tail = size > end ? size - end : 0;
+		padding += tail;
+
+		/* Largest alignment first leaves no holes between fields whose sizes are multiples of their alignments */
+
+		auto suggested = fields;
+
+		std::stable_sort(suggested.begin(), suggested.end(), [](const field_layout& a, const field_layout& b) {
+			return a.alignment > b.alignment;
+		});
+
+		std::size_t suggested_end = first_offset;
+
+		for (auto& f : suggested) {
+			f.offset = align_up(suggested_end, f.alignment);
+			suggested_end = f.offset + f.size;
+		}
+
+		const auto suggested_size = std::max(align_up(suggested_end, alignment), alignment);
+
+		const auto splits = count_cache_line_splits(fields);
+		const auto suggested_splits = count_cache_line_splits(suggested);
+
+		std::printf("  tail padding: %zu, total padding: %zu, cache line splits: %zu\n", tail, padding, splits);
+
+		total_padding += padding;
+
+		if (suggested_size < size || (suggested_size == size && suggested_splits < splits)) {
+			total_savings += size - suggested_size;
+
+			std::printf("  suggested order (size %zu, cache line splits: %zu):", suggested_size, suggested_splits);
+
+			for (const auto& f : suggested) {
+				std::printf(" %s", f.name);
+			}
+
+			std::printf("\n");
+		}
+
+		std::printf("\n");
+	}
+)";
+
+template <class Out>
+void emit_layout_report(
+	const std::string& report_path,
+	const std::vector<std::string>& header_files,
+	const scan_cache& model,
+	Out& out
+) {
+	const auto put = [&](const std::string_view s) {
+		out.append(s.data(), s.size());
+	};
+
+	const auto is_measured = [](const introspected_type& t) {
+		return !t.is_enum() && t.template_arguments.empty();
+	};
+
+	put("/* Generated by Introspector-generator. Compile and run to see the layouts of the introspected types. */\n");
+	put("#include <algorithm>\n#include <cstddef>\n#include <cstdio>\n#include <vector>\n\n");
+
+	const auto from = fs::absolute(report_path).lexically_normal().parent_path();
+
+	std::vector<const introspected_type*> measured;
+
+	for (const auto& path : header_files) {
+		const auto found = model.entries.find(path);
+
+		if (found == model.entries.end()) {
+			continue;
+		}
+
+		bool has_measured = false;
+
+		for (const auto& t : found->second.types) {
+			if (is_measured(t)) {
+				measured.push_back(&t);
+				has_measured = true;
+			}
+		}
+
+		if (has_measured) {
+			const auto relative = fs::absolute(path).lexically_normal().lexically_relative(from);
+			put("#include \"" + relative.generic_string() + "\"\n");
+		}
+	}
+
+	put(layout_report_preamble);
+
+	std::string tags;
+	std::string reports;
+	std::size_t num_tags = 0;
+
+	for (const auto t : measured) {
+		const auto type_name = "::" + make_type_naming(*t).type_name;
+
+		reports += typesafe_sprintf("\n\treport(\"%x\", sizeof(%x), alignof(%x), {\n", t->type_name_without_templates, type_name, type_name);
+
+		for (const auto& l : t->lines) {
+			if (l.type == block_line_type::INTACT) {
+				if (l.text.find_first_not_of(" \t\r") != std::string::npos) {
+					tags.append(l.text) += '\n';
+					reports.append(l.text) += '\n';
+				}
+
+				continue;
+			}
+
+			const auto tag = "layout_tag_" + std::to_string(num_tags++);
+
+			tags += typesafe_sprintf("\n\tstruct %x { friend constexpr auto get_member(%x); };\n", tag, tag);
+			tags += typesafe_sprintf("\ttemplate struct layout_expose<%x, &%x::%x>;\n", tag, type_name, l.text);
+
+			reports += typesafe_sprintf("\t\tmake_field_layout<%x>(\"%x\", get_member(%x())),\n", type_name, l.text, tag);
+		}
+
+		reports += "\t});\n";
+	}
+
+	put(tags);
+	put("}\n\nint main() {");
+	put(reports);
+	put("\n\tstd::printf(\"Total padding: %zu, saved by the suggested orders: %zu\\n\", total_padding, total_savings);\n\treturn 0;\n}\n");
+}
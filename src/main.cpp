@@ -1,10 +1,17 @@
 #include <algorithm>
 #include <iostream>
-#include <map>
 #include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <memory>
 #include <variant>
+#include <vector>
 
 #include "spellbook.h"
+#include "introspector_generator.h"
+#include "generator.h"
+#include "watch_mode.h"
+#include "depfile.h"
 
 using namespace std::chrono;
 
@@ -19,442 +26,123 @@ int main(int argc, char** argv) {
 
 	static_assert("C++17");
 
-	if (const auto cxx17iftest = !(argc >= 2);
-		cxx17iftest
-	) {
-		std::cout << "usage: configuration_file_input_path" << std::endl;
-		return 0;
-	}
+	/* Several configurations are generated in a single batch, see generate_files_batch */
+	std::vector<std::string> configuration_file_input_paths;
+	std::size_t num_jobs = get_default_num_jobs();
+	bool watch = false;
+	bool print_stats = false;
+	std::string trace_path;
+	std::string depfile_path;
 
-	const std::string configuration_file_input_path = argv[1];
+	const auto usage = "usage: configuration_file_input_path [more configuration files...] [--jobs N] [--watch] [--stats] [--trace trace.json] [--depfile generator.d]";
 
-	auto guarded_create_file = [](
-		const std::string& path,
-		const std::string& new_contents
-		) {
-		if (!fs::exists(path) || file_to_string(path) != new_contents) {
-			create_text_file(path, new_contents);
-		}
+	auto fail_with_usage = [&](const std::string& problem) {
+		std::cout << "Failure\n" << problem << "\n" << usage << std::endl;
+		return 1;
 	};
 
-	std::string beginning_line;
-	std::string ending_line;
-	std::vector<std::string> header_directories;
-	std::vector<std::string> header_files;
-	std::string generated_file_path;
-	std::string generated_enums_path;
-	std::string generated_specializations_path;
-	std::string introspector_field_format;
-	std::string introspector_body_format;
-	std::string specialized_list_format;
-	std::string enum_field_format;
-	std::string enum_introspector_body_format;
-	std::string enum_arg_format;
-	std::string enum_to_args_body_format;
-	std::string generated_file_format;
-
-	{
-		const auto cfg = get_file_lines(configuration_file_input_path);
-		
-		try {
-			if (cfg.size() == 0) {
-				throw std::exception();
-			}
-
-			const auto lines_per_prop = break_lines_by_properties(
-				cfg,
-				{
-					"beginning-line:",
-					"ending-line:",
-					"header-directories:",
-					"header-files:",
-					"generated-file-path:",
-					"generated-enums-path:",
-					"generated-specializations-path:",
-					"introspector-field-format:",
-					"introspector-body-format:",
-					"specialized-list-format:",
-					"enum-field-format:",
-					"enum-introspector-body-format:",
-					"enum-arg-format:",
-					"enum-to-args-body-format:",
-					"generated-file-format:"
-				}
-			);
-
-			std::size_t i = 0u;
-
-			beginning_line = lines_per_prop[i++][0];
-			ending_line = lines_per_prop[i++][0];
-			header_directories = lines_per_prop[i++];
-			header_files = lines_per_prop[i++];
-			generated_file_path = lines_per_prop[i++][0];
-			generated_enums_path = lines_per_prop[i++][0];
-			generated_specializations_path = lines_per_prop[i++][0];
-			introspector_field_format = lines_to_string(lines_per_prop[i++]);
-			introspector_body_format = lines_to_string(lines_per_prop[i++]);
-			specialized_list_format = lines_to_string(lines_per_prop[i++]);
-			enum_field_format = lines_to_string(lines_per_prop[i++]);
-			enum_introspector_body_format = lines_to_string(lines_per_prop[i++]);
-			enum_arg_format = lines_to_string(lines_per_prop[i++]);
-			enum_to_args_body_format = lines_to_string(lines_per_prop[i++]);
-			generated_file_format = lines_to_string(lines_per_prop[i++]);
-		}
-		catch (...) {
-			std::cout << "Failure\nError while reading configuration values." << std::endl;
-			return 1;
+	/* Only a positive number of jobs, written in digits alone */
+	auto parse_num_jobs = [&](const std::string& value) {
+		if (value.empty() || value.size() > 6 || value.find_first_not_of("0123456789") != std::string::npos) {
+			return std::size_t(0);
 		}
-	}
-
-
-	std::vector<std::string> generated_files_for_inclusion;
 
-	std::string generated_introspectors;
-	std::string generated_specializations;
-	std::string generated_enums;
+		return static_cast<std::size_t>(std::strtoul(value.c_str(), nullptr, 10));
+	};
 
-	std::map<std::string, std::string> namespaces;
+	for (int a = 1; a < argc; ++a) {
+		const std::string arg = argv[a];
 
-	const auto make_namespaces = [&]() {
-		std::string all;
+		const bool takes_value = arg == "--jobs" || arg == "--trace" || arg == "--depfile";
 
-		for (const auto& n : namespaces) {
-			if (n.first == "<unnamed>") {
-				all += typesafe_sprintf("%x\n", n.second);
-			}
-			else {
-				all += typesafe_sprintf("namespace %x {\n%x}\n\n", n.first, n.second);
-			}
+		if (takes_value && a + 1 >= argc) {
+			return fail_with_usage(arg + " needs a value.");
 		}
 
-		return all;
-	};
-
-	for (const auto dirpath : header_directories) {
-		for (fs::recursive_directory_iterator i(dirpath), end; i != end; ++i) {
-			if (!is_directory(i->path())) {
-				const auto path = i->path();
+		if (arg == "--jobs" || arg.rfind("--jobs=", 0) == 0) {
+			const std::string value = arg == "--jobs" ? argv[++a] : arg.substr(7);
+			num_jobs = parse_num_jobs(value);
 
-				if (path.extension() == ".h") {
-					header_files.push_back(path.string());
-				}
+			if (num_jobs == 0) {
+				return fail_with_usage("--jobs needs a positive number, not \"" + value + "\".");
 			}
 		}
+		else if (arg == "--watch") {
+			watch = true;
+		}
+		else if (arg == "--stats") {
+			print_stats = true;
+		}
+		else if (arg == "--trace") {
+			trace_path = argv[++a];
+		}
+		else if (arg.rfind("--trace=", 0) == 0) {
+			trace_path = arg.substr(8);
+		}
+		else if (arg == "--depfile") {
+			depfile_path = argv[++a];
+		}
+		else if (arg.rfind("--depfile=", 0) == 0) {
+			depfile_path = arg.substr(10);
+		}
+		else if (arg.rfind("--", 0) == 0) {
+			return fail_with_usage("Unknown option: " + arg);
+		}
+		else {
+			configuration_file_input_paths.push_back(arg);
+		}
 	}
 
-	try {
-		for(const auto& path : header_files) {
-			const auto lines = get_file_lines(path);
+	if (const auto cxx17iftest = configuration_file_input_paths.empty();
+		cxx17iftest
+	) {
+		std::cout << usage << std::endl;
+		return 0;
+	}
 
-			size_t current_line = 0;
+	std::unique_ptr<run_stats> stats_storage;
 
-			const auto errcheck = [&](const bool flag) {
-				if (!flag) {
-					const auto error_contents = typesafe_sprintf(
-						"A problem in line %x in file %x:\n%x\n",
-						current_line,
-						path,
-						lines[current_line]
-					);
+	if (print_stats || !trace_path.empty()) {
+		stats_storage = std::make_unique<run_stats>(!trace_path.empty());
+	}
 
-					create_text_file(generated_file_path, "#error " + error_contents);
+	const auto stats = stats_storage.get();
 
-					std::cout << "------------\nIntrospector-generator run failed." << std::endl;
-					std::cout << error_contents << std::endl;
-					std::cout << "------------\n";
+	std::vector<generator_configuration> cfgs;
 
-					throw std::exception();
-				}
-			};
-
-			while (current_line < lines.size()) {
-				const auto found_gen_begin = lines[current_line].find(beginning_line);
+	for (const auto& path : configuration_file_input_paths) {
+		try {
+			run_stats_scope scope(stats, run_phase::CONFIGURATION, "read_generator_configuration");
+			cfgs.push_back(introspector_generator::read_configuration(path));
+		}
+		catch (...) {
+			std::cout << "Failure\nError while reading configuration values." << std::endl;
 
-				if (found_gen_begin != std::string::npos) {
-					const auto after_gen = lines[current_line].substr(found_gen_begin + beginning_line.length());
-					std::istringstream in(after_gen);
+			if (configuration_file_input_paths.size() > 1) {
+				std::cout << "Configuration file: " << path << std::endl;
+			}
 
-					std::string struct_or_class_or_enum;
-					in >> struct_or_class_or_enum;
+			return 1;
+		}
+	}
+
+	if (watch) {
+		if (cfgs.size() > 1) {
+			std::cout << "Failure\n--watch takes a single configuration file." << std::endl;
+			return 1;
+		}
 
-					const bool is_enum =
-						struct_or_class_or_enum == "enum"
-						;
+		return run_watch_mode(configuration_file_input_paths[0], cfgs[0], num_jobs);
+	}
 
-					errcheck(
-						struct_or_class_or_enum == "struct"
-						|| struct_or_class_or_enum == "class"
-						|| is_enum
-					);
-
-					std::string type_name;
-
-					std::string argument_template_arguments;
-					std::string template_template_arguments;
-
-					std::string type_name_without_templates;
-					
-					if (is_enum) {
-						in >> type_name_without_templates;
+	std::vector<written_outputs_summary> summaries;
 
-						if (type_name_without_templates == "class") {
-							struct_or_class_or_enum = "enum class";
-							in >> type_name_without_templates;
-						}
-					}
-					else {
-						in >> type_name_without_templates;
-					}
-
-					type_name = type_name_without_templates;
-
-					std::vector <std::pair<std::string, std::string>> template_arguments;
-
-					std::string template_arg_type;
-					std::string template_arg_name;
-
-					while (in >> template_arg_type && in >> template_arg_name) {
-						template_arguments.push_back({ template_arg_type, template_arg_name });
-					}
-
-					if (template_arguments.size() > 0) {
-						argument_template_arguments = "<";
-						template_template_arguments = ", ";
-
-						for (size_t a = 0; a < template_arguments.size(); ++a) {
-							argument_template_arguments += template_arguments[a].second;
-							
-							if (template_arguments[a].first.find("...") != std::string::npos) {
-								argument_template_arguments += "...";
-							}
-
-							template_template_arguments += template_arguments[a].first + " " + template_arguments[a].second;
-
-							if (a != template_arguments.size() - 1) {
-								argument_template_arguments += ", ";
-								template_template_arguments += ", ";
-							}
-						}
-
-						argument_template_arguments += ">";
-
-						type_name += argument_template_arguments;
-					}
-
-					std::string type_without_namespace = type_name_without_templates;
-					std::string namespace_of_type = "<unnamed>";
-
-					const auto found_colons = type_name_without_templates.find("::");
-
-					if (found_colons != std::string::npos) {
-						const auto& name = type_name_without_templates;
-
-						namespace_of_type = name.substr(0, found_colons);
-						type_without_namespace = name.substr(found_colons + 2);
-					}
-
-					std::vector<std::string> forward_declaration_lines;
-
-					if (template_arguments.size()) {
-						forward_declaration_lines.push_back(
-							typesafe_sprintf("template %x\n", "<" + template_template_arguments.substr(2) + ">")
-						);
-					}
-					
-					forward_declaration_lines.push_back(
-						typesafe_sprintf(
-							"%x %x;\n",
-							struct_or_class_or_enum,
-							type_without_namespace
-						)
-					);
-
-					const bool should_add_tabulation = namespace_of_type != "<unnamed>";
-
-					if (should_add_tabulation) {
-						for (auto& l : forward_declaration_lines) {
-							l = "	" + l;
-						}
-					}
-
-					for (const auto& l : forward_declaration_lines) {
-						namespaces[namespace_of_type] += l;
-					}
-
-					std::string generated_fields;
-					std::string generated_fields_list;
-					std::string generated_enum_args;
-					int num_generated_fields = 0;
-
-					auto redirect_line_intact = [&](const std::string& line) {
-						generated_fields += line + '\n';
-						generated_fields_list += line + '\n';
-						generated_enum_args += line + '\n';
-					};
-
-					while (true) {
-						++current_line;
-
-						const auto& new_field_line = lines[current_line];
-
-						if (new_field_line.find(ending_line) != std::string::npos) {
-							break;
-						}
-						
-						if (new_field_line[0] == '#') {
-							redirect_line_intact(new_field_line);
-							continue;
-						}
-
-						if (std::all_of(new_field_line.begin(), new_field_line.end(), isspace)) {
-							redirect_line_intact(new_field_line);
-							continue;
-						}
-
-						if (is_enum) {
-							const auto field_name_beginning = new_field_line.find_first_not_of(" \t\r");
-							errcheck(field_name_beginning != std::string::npos);
-							errcheck(new_field_line.find("=") == std::string::npos);
-
-							auto field_name_ending = new_field_line.find_first_of("=, \t\r", field_name_beginning);
-
-							if (field_name_ending == std::string::npos) {
-								field_name_ending = new_field_line.size();
-							}
-
-							const auto field_name = new_field_line.substr(field_name_beginning, field_name_ending - field_name_beginning);
-
-							generated_fields += typesafe_sprintf(
-								enum_field_format,
-								field_name
-							);
-
-							++num_generated_fields;
-
-							if (enum_arg_format.size() > 0) {
-								generated_enum_args += typesafe_sprintf(
-									enum_arg_format,
-									field_name
-								);
-							}
-						}
-						else {
-							static const std::string skip_keywords[] = {
-								"private:",
-								"protected:",
-								"public:",
-								"friend ",
-								"using ",
-								"typedef "
-							};
-
-							bool should_skip = false;
-
-							for (const auto& k : skip_keywords) {
-								if (new_field_line.find(k) != std::string::npos) {
-									should_skip = true;
-								}
-							}
-
-							if (should_skip) {
-								continue;
-							}
-
-							std::string field_name;
-							std::string field_type;
-
-							std::size_t field_name_beginning = std::string::npos;
-							std::size_t field_name_ending = std::string::npos;
-							
-							const auto found_eq = new_field_line.find("=");
-
-							if (found_eq != std::string::npos) {
-								field_name_ending = new_field_line.find(" =");
-								errcheck(field_name_ending != std::string::npos);
-								field_name_beginning = new_field_line.rfind(" ", field_name_ending - 1) + 1;
-							}
-							else {
-								field_name_ending = new_field_line.find(";");
-								errcheck(field_name_ending != std::string::npos);
-								field_name_beginning = new_field_line.rfind(" ", field_name_ending) + 1;
-							}
-							
-							field_name = new_field_line.substr(
-								field_name_beginning, field_name_ending - field_name_beginning
-							);
-
-							const auto field_type_beginning = new_field_line.find_first_not_of(" \t\r");
-
-							field_type = new_field_line.substr(
-								field_type_beginning,
-								field_name_beginning - field_type_beginning - 1 // peel off the trailing space
-							);
-
-							errcheck(field_name.find_first_of("[]") == std::string::npos);
-
-							generated_fields += typesafe_sprintf(
-								introspector_field_format,
-								field_name,
-								field_type
-							);
-
-							auto new_field = typesafe_sprintf("TYPEOF(%x)\n", field_name);
-
-							if (num_generated_fields > 0) {
-								new_field = ", " + new_field;
-							}
-
-							generated_fields_list += new_field;
-							++num_generated_fields;
-						}
-					}
-
-					if (is_enum) {
-						generated_enums += typesafe_sprintf(
-							enum_introspector_body_format,
-							"::" + type_name,
-							num_generated_fields,
-							generated_fields,
-							num_generated_fields
-						);
-
-						if (generated_enum_args.size() > 0) {
-							const auto cm = generated_enum_args.rfind(',');
-
-							if (cm != std::string::npos) {
-								generated_enum_args.erase(generated_enum_args.begin() + cm); // peel off the trailing comma
-							}
-						}
-
-						if (enum_to_args_body_format.size() > 0) {
-							generated_enums += typesafe_sprintf(
-								enum_to_args_body_format,
-								"::" + type_name,
-								generated_enum_args
-							);
-						}
-					}
-					else {
-						generated_introspectors += typesafe_sprintf(
-							introspector_body_format,
-							template_template_arguments,
-							typesafe_sprintf("const ::%x* const", type_name),
-							//type_name,
-							generated_fields
-						);
-
-						generated_specializations += typesafe_sprintf(
-							specialized_list_format,
-							template_template_arguments,
-							"::" + type_name,
-							generated_fields_list
-						);
-					}
-				}
-
-				++current_line;
-			}
-		}
+	try {
+		summaries = introspector_generator::generate_files_batch(cfgs, num_jobs, stats);
+	}
+	catch (const header_parse_error& err) {
+		report_parse_error(cfgs, err);
+		return 1;
 	}
 	catch (std::exception err) {
 		std::cout << "Exception thrown during header processing: " << err.what() << std::endl;
@@ -462,32 +150,41 @@ int main(int argc, char** argv) {
 		return 1;
 	}
 
-	const auto generated_file = typesafe_sprintf(
-		generated_file_format,
-		make_namespaces(),
-		generated_introspectors
-	);
+	std::cout << "Success" << std::endl;
 
-	const auto generated_enums_contents = make_namespaces() + "\n" + generated_enums;
+	for (std::size_t c = 0; c < cfgs.size(); ++c) {
+		std::cout << "Written the generated introspectors to:\n" << cfgs[c].generated_file_path << std::endl;
+		std::cout << "Lines: " << summaries[c].generated_file_lines << std::endl;
+		std::cout << "Enum Lines: " << summaries[c].generated_enums_lines << std::endl;
 
-	guarded_create_file(
-		generated_file_path,
-		generated_file
-	);
+		for (const auto& root : summaries[c].unknown_root_types) {
+			std::cout << "Warning: no introspected type is named " << root << ", as given in root-types." << std::endl;
+		}
 
-	guarded_create_file(
-		generated_specializations_path,
-		generated_specializations
-	);
+		if (!summaries[c].pruned_types.empty()) {
+			std::cout << "Pruned " << summaries[c].pruned_types.size() << " type(s) unreachable from root-types:" << std::endl;
 
-	guarded_create_file(
-		generated_enums_path,
-		generated_enums_contents
-	);
+			for (const auto& t : summaries[c].pruned_types) {
+				std::cout << "  " << t << std::endl;
+			}
+		}
+	}
+
+	if (!depfile_path.empty()) {
+		guarded_create_file(
+			depfile_path,
+			make_depfile(cfgs, configuration_file_input_paths, summaries)
+		);
+	}
 
-	std::cout << "Success\nWritten the generated introspectors to:\n" << generated_file_path << std::endl;
-	std::cout << "Lines: " << std::count(generated_file.begin(), generated_file.end(), '\n') << std::endl;
-	std::cout << "Enum Lines: " << std::count(generated_enums_contents.begin(), generated_enums_contents.end(), '\n') << std::endl;
+	if (print_stats) {
+		stats->print(std::cout);
+	}
+
+	if (!trace_path.empty()) {
+		stats->write_trace(trace_path);
+		std::cout << "Trace written to:\n" << trace_path << std::endl;
+	}
 
 	std::variant<int, double> variant_test;
 	variant_test = 0;
@@ -0,0 +1,140 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <sstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+	Read-only view of a whole file.
+
+	On POSIX systems the file is memory-mapped, so reading it costs no copies and no allocations.
+	Elsewhere it is read into a single buffer in text mode,
+	so that line endings are exactly the same as with std::getline.
+
+	A mapping turns a file that gets truncated while it is mapped into SIGBUS,
+	so a caller that reads files other programs are editing right now (e.g. the watch mode)
+	passes allow_mapping = false to read the file into the buffer with plain reads instead.
+
+	A file that could not be opened is simply empty.
+*/
+
+class mapped_file {
+	std::string buffer;
+
+#if !defined(_WIN32)
+	void* mapping = nullptr;
+	std::size_t mapping_size = 0;
+#endif
+
+	std::string_view view;
+
+	void release() {
+#if !defined(_WIN32)
+		if (mapping != nullptr) {
+			::munmap(mapping, mapping_size);
+			mapping = nullptr;
+			mapping_size = 0;
+		}
+#endif
+		buffer.clear();
+		view = {};
+	}
+
+public:
+	mapped_file() = default;
+
+	explicit mapped_file(const std::string& path, const bool allow_mapping = true) {
+#if defined(_WIN32)
+		(void)allow_mapping;
+
+		std::ifstream t(path);
+		std::stringstream s;
+		s << t.rdbuf();
+		buffer = s.str();
+		view = buffer;
+#else
+		const auto fd = ::open(path.c_str(), O_RDONLY);
+
+		if (fd == -1) {
+			return;
+		}
+
+		struct stat st;
+
+		if (!allow_mapping) {
+			if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+				buffer.reserve(static_cast<std::size_t>(st.st_size));
+			}
+
+			char chunk[64 * 1024];
+
+			for (;;) {
+				const auto n = ::read(fd, chunk, sizeof(chunk));
+
+				if (n <= 0) {
+					break;
+				}
+
+				buffer.append(chunk, static_cast<std::size_t>(n));
+			}
+
+			view = buffer;
+		}
+		else if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+			const auto size = static_cast<std::size_t>(st.st_size);
+			const auto m = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+			if (m != MAP_FAILED) {
+				mapping = m;
+				mapping_size = size;
+				view = std::string_view(static_cast<const char*>(m), size);
+			}
+		}
+
+		::close(fd);
+#endif
+	}
+
+	mapped_file(mapped_file&& b) noexcept {
+		*this = std::move(b);
+	}
+
+	mapped_file& operator=(mapped_file&& b) noexcept {
+		if (this != &b) {
+			release();
+
+			const bool owns_buffer = b.view.data() == b.buffer.data();
+			buffer = std::move(b.buffer);
+			view = owns_buffer ? std::string_view(buffer) : b.view;
+#if !defined(_WIN32)
+			mapping = b.mapping;
+			mapping_size = b.mapping_size;
+
+			b.mapping = nullptr;
+			b.mapping_size = 0;
+#endif
+			b.view = {};
+		}
+
+		return *this;
+	}
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	~mapped_file() {
+		release();
+	}
+
+	std::string_view contents() const {
+		return view;
+	}
+};
@@ -0,0 +1,182 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INTROSPECTOR_GENERATOR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if INTROSPECTOR_GENERATOR_SSE2 && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define INTROSPECTOR_GENERATOR_AVX2 1
+#include <immintrin.h>
+#endif
+
+/*
+	Finds the first occurrence of a marker in a whole file.
+
+	Most headers contain no marker at all, so this runs over every byte of the scanned tree.
+	The vectorized versions compare the first and the last character of the marker
+	against a whole block of the haystack at once, and only the positions where both match
+	are verified with memcmp. AVX2 is picked at runtime when the CPU supports it,
+	otherwise SSE2 is used where available, with a scalar memchr fallback everywhere else.
+*/
+
+namespace marker_search_detail {
+	inline bool matches_at(
+		const char* const haystack,
+		const std::string_view needle,
+		const std::size_t pos
+	) {
+		return std::memcmp(haystack + pos + 1, needle.data() + 1, needle.size() - 2) == 0;
+	}
+
+	inline std::size_t find_scalar(
+		const std::string_view haystack,
+		const std::string_view needle,
+		std::size_t from
+	) {
+		const auto last_start = haystack.size() - needle.size();
+
+		while (from <= last_start) {
+			const auto found = static_cast<const char*>(
+				std::memchr(haystack.data() + from, needle[0], last_start - from + 1)
+			);
+
+			if (found == nullptr) {
+				break;
+			}
+
+			const auto pos = static_cast<std::size_t>(found - haystack.data());
+
+			if (std::memcmp(found, needle.data(), needle.size()) == 0) {
+				return pos;
+			}
+
+			from = pos + 1;
+		}
+
+		return std::string_view::npos;
+	}
+
+	inline int lowest_bit(const unsigned mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return static_cast<int>(index);
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+#if INTROSPECTOR_GENERATOR_SSE2
+	inline std::size_t find_sse2(
+		const std::string_view haystack,
+		const std::string_view needle,
+		std::size_t from
+	) {
+		constexpr std::size_t block = 16;
+
+		const auto first = _mm_set1_epi8(needle.front());
+		const auto last = _mm_set1_epi8(needle.back());
+		const auto last_offset = needle.size() - 1;
+		const auto* const data = haystack.data();
+
+		for (; from + last_offset + block <= haystack.size(); from += block) {
+			const auto block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + from));
+			const auto block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + from + last_offset));
+
+			auto mask = static_cast<unsigned>(_mm_movemask_epi8(
+				_mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))
+			));
+
+			while (mask != 0) {
+				const auto pos = from + lowest_bit(mask);
+
+				if (matches_at(data, needle, pos)) {
+					return pos;
+				}
+
+				mask &= mask - 1;
+			}
+		}
+
+		return find_scalar(haystack, needle, from);
+	}
+#endif
+
+#if INTROSPECTOR_GENERATOR_AVX2
+	__attribute__((target("avx2")))
+	inline std::size_t find_avx2(
+		const std::string_view haystack,
+		const std::string_view needle,
+		std::size_t from
+	) {
+		constexpr std::size_t block = 32;
+
+		const auto first = _mm256_set1_epi8(needle.front());
+		const auto last = _mm256_set1_epi8(needle.back());
+		const auto last_offset = needle.size() - 1;
+		const auto* const data = haystack.data();
+
+		for (; from + last_offset + block <= haystack.size(); from += block) {
+			const auto block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + from));
+			const auto block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + from + last_offset));
+
+			auto mask = static_cast<unsigned>(_mm256_movemask_epi8(
+				_mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last))
+			));
+
+			while (mask != 0) {
+				const auto pos = from + lowest_bit(mask);
+
+				if (matches_at(data, needle, pos)) {
+					return pos;
+				}
+
+				mask &= mask - 1;
+			}
+		}
+
+		return find_sse2(haystack, needle, from);
+	}
+
+	inline bool cpu_has_avx2() {
+		static const bool has = __builtin_cpu_supports("avx2");
+		return has;
+	}
+#endif
+}
+
+inline std::size_t find_marker(
+	const std::string_view haystack,
+	const std::string_view needle,
+	const std::size_t from = 0
+) {
+	using namespace marker_search_detail;
+
+	if (needle.size() < 2) {
+		return haystack.find(needle, from);
+	}
+
+	if (from > haystack.size() || haystack.size() - from < needle.size()) {
+		return std::string_view::npos;
+	}
+
+#if INTROSPECTOR_GENERATOR_AVX2
+	if (cpu_has_avx2()) {
+		return find_avx2(haystack, needle, from);
+	}
+#endif
+
+#if INTROSPECTOR_GENERATOR_SSE2
+	return find_sse2(haystack, needle, from);
+#else
+	return find_scalar(haystack, needle, from);
+#endif
+}
@@ -0,0 +1,207 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "spellbook.h"
+#include "run_stats.h"
+
+/*
+	What we know about a generated file from the last time we wrote it.
+	If the file's size and mtime still match, its contents are known to hash to content_hash,
+	and the file does not have to be read back to be compared.
+*/
+
+struct output_record {
+	std::uint64_t size = 0;
+	std::int64_t mtime = -1;
+	std::uint64_t content_hash = 0;
+};
+
+inline std::int64_t get_mtime(const std::string& path, std::error_code& err) {
+	return static_cast<std::int64_t>(fs::last_write_time(path, err).time_since_epoch().count());
+}
+
+/*
+	Streams a generated file in chunks to a temporary file next to it, hashing it on the way.
+
+	On commit, the temporary file replaces the target with an atomic rename,
+	but only if the contents differ, so that the mtime of unchanged outputs stays stable.
+	Neither the new nor the old contents are ever held in memory as a whole.
+
+	With stats, the time spent writing and comparing is kept apart,
+	so that the caller can tell it from the time spent formatting.
+*/
+
+class streaming_file_writer {
+	std::string path;
+	std::string temporary_path;
+	std::ofstream out;
+
+	std::uint64_t content_hash = fnv1a_64(nullptr, 0);
+	std::size_t num_lines = 0;
+	std::uint64_t num_bytes = 0;
+
+	run_stats* const stats;
+	run_stats::clock::duration io_time = {};
+
+	static bool files_equal(const std::string& a, const std::string& b) {
+		std::ifstream fa(a, std::ios::in | std::ios::binary);
+		std::ifstream fb(b, std::ios::in | std::ios::binary);
+
+		char buffer_a[64 * 1024];
+		char buffer_b[64 * 1024];
+
+		while (fa && fb) {
+			fa.read(buffer_a, sizeof(buffer_a));
+			fb.read(buffer_b, sizeof(buffer_b));
+
+			if (fa.gcount() != fb.gcount() || std::memcmp(buffer_a, buffer_b, static_cast<std::size_t>(fa.gcount())) != 0) {
+				return false;
+			}
+		}
+
+		return !fa && !fb;
+	}
+
+public:
+	explicit streaming_file_writer(
+		const std::string& path,
+		run_stats* const stats = nullptr,
+		const std::ios::openmode mode = std::ios::out
+	) :
+		path(path),
+		temporary_path(path + ".tmp"),
+		out(temporary_path, mode),
+		stats(stats)
+	{}
+
+	streaming_file_writer(const streaming_file_writer&) = delete;
+	streaming_file_writer& operator=(const streaming_file_writer&) = delete;
+
+	~streaming_file_writer() {
+		if (out.is_open()) {
+			out.close();
+
+			std::error_code err;
+			fs::remove(temporary_path, err);
+		}
+	}
+
+	void append(const char* const data, const std::size_t size) {
+		const auto start = stats ? run_stats::clock::now() : run_stats::clock::time_point();
+
+		out.write(data, static_cast<std::streamsize>(size));
+		content_hash = fnv1a_64(data, size, content_hash);
+		num_lines += static_cast<std::size_t>(std::count(data, data + size, '\n'));
+		num_bytes += size;
+
+		if (stats) {
+			const auto write_time = run_stats::clock::now() - start;
+
+			stats->add_time(run_phase::OUTPUT_WRITE, write_time);
+			io_time += write_time;
+		}
+	}
+
+	streaming_file_writer& operator+=(const std::string_view s) {
+		append(s.data(), s.size());
+		return *this;
+	}
+
+	std::size_t get_num_lines() const {
+		return num_lines;
+	}
+
+	/* Time spent in writes and in the comparison on commit, if there are stats */
+
+	run_stats::clock::duration get_io_time() const {
+		return io_time;
+	}
+
+	/*
+		Replaces the target file if its contents differ. Returns true if it did.
+		The record is consulted to skip reading the existing file back, and is updated afterwards.
+	*/
+
+	bool commit(output_record& record) {
+		const auto start = stats ? run_stats::clock::now() : run_stats::clock::time_point();
+
+		out.close();
+
+		std::error_code err;
+
+		bool identical = false;
+
+		if (const auto existing_size = fs::file_size(path, err); !err) {
+			const auto existing_mtime = get_mtime(path, err);
+			const auto new_size = fs::file_size(temporary_path, err);
+
+			if (!err && existing_size == record.size && existing_mtime == record.mtime) {
+				identical = new_size == record.size && content_hash == record.content_hash;
+			}
+			else {
+				identical = !err && new_size == existing_size && files_equal(temporary_path, path);
+			}
+		}
+
+		if (identical) {
+			fs::remove(temporary_path, err);
+		}
+		else {
+			fs::rename(temporary_path, path);
+		}
+
+		record.size = static_cast<std::uint64_t>(fs::file_size(path, err));
+		record.mtime = get_mtime(path, err);
+		record.content_hash = content_hash;
+
+		if (stats) {
+			const auto end = run_stats::clock::now();
+
+			stats->add_time(run_phase::OUTPUT_COMPARE, end - start);
+			stats->add_trace_event("commit", path, start, end);
+
+			io_time += end - start;
+
+			if (identical) {
+				++stats->outputs_unchanged;
+			}
+			else {
+				++stats->outputs_replaced;
+			}
+
+			stats->bytes_generated += num_bytes;
+		}
+
+		return !identical;
+	}
+
+	bool commit() {
+		output_record unknown;
+		return commit(unknown);
+	}
+};
+
+inline void guarded_create_file(
+	const std::string& path,
+	const std::string_view new_contents,
+	output_record& record,
+	run_stats* const stats = nullptr
+) {
+	streaming_file_writer out(path, stats);
+	out += new_contents;
+	out.commit(record);
+}
+
+inline void guarded_create_file(
+	const std::string& path,
+	const std::string_view new_contents
+) {
+	streaming_file_writer out(path);
+	out += new_contents;
+	out.commit();
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+inline std::size_t get_default_num_jobs() {
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/*
+	Calls f(i) for every i in [0, count) on up to num_jobs threads,
+	the calling thread included. Indices are handed out dynamically,
+	so it is up to f to write its result into a slot of its own.
+	f must not throw.
+*/
+
+template <class F>
+void parallel_for(const std::size_t num_jobs, const std::size_t count, F&& f) {
+	const auto num_threads = std::min(std::max(num_jobs, std::size_t(1)), count);
+
+	if (num_threads <= 1) {
+		for (std::size_t i = 0; i < count; ++i) {
+			f(i);
+		}
+
+		return;
+	}
+
+	std::atomic<std::size_t> next_index = 0;
+
+	auto worker = [&]() {
+		for (auto i = next_index++; i < count; i = next_index++) {
+			f(i);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(num_threads - 1);
+
+	for (std::size_t t = 0; t < num_threads - 1; ++t) {
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for (auto& t : threads) {
+		t.join();
+	}
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+/*
+	A collision-free hash over a fixed set of distinct strings, found at generation time
+	with the hash-and-displace method, so that a generated string_to_enum is a table lookup.
+
+	The generated code must compute exactly the same hash as perfect_hash_string:
+	32-bit FNV-1a whose offset basis is xored with a seed, followed by a few mixing steps.
+	Only the low bits of the hash are used, and without the mixing they would depend only on the low bits of the seed.
+
+	A key is looked up in two steps:
+
+		seed = seeds[perfect_hash_string(key, 0) & (seeds.size() - 1)]
+		index = slots[perfect_hash_string(key, seed) & (slots.size() - 1)]
+
+	index is the position of the key in the original set, or -1 for a slot that no key maps to.
+	A key from outside the set may still land on a taken slot, so the caller compares it with the key at index.
+
+	Equal keys can never be told apart, so make_perfect_hash throws std::invalid_argument for them,
+	and callers that can name the culprit better check with find_duplicate_key first.
+	The table is made larger only a few times before make_perfect_hash gives up with std::runtime_error.
+*/
+
+constexpr std::uint32_t perfect_hash_feed(std::uint32_t hash, const std::string_view s) {
+	for (const auto c : s) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+constexpr std::uint32_t perfect_hash_finish(std::uint32_t hash) {
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+
+	return hash;
+}
+
+constexpr std::uint32_t perfect_hash_string(const std::string_view s, const std::uint32_t seed) {
+	return perfect_hash_finish(perfect_hash_feed(2166136261u ^ seed, s));
+}
+
+/* The hash of the parts joined together, without joining them, e.g. for keys like "type::field" */
+constexpr std::uint32_t perfect_hash_concatenation(const std::initializer_list<std::string_view> parts, const std::uint32_t seed) {
+	std::uint32_t hash = 2166136261u ^ seed;
+
+	for (const auto& p : parts) {
+		hash = perfect_hash_feed(hash, p);
+	}
+
+	return perfect_hash_finish(hash);
+}
+
+struct perfect_hash {
+	/* Both sizes are powers of two */
+	std::vector<std::uint32_t> seeds;
+	std::vector<int> slots;
+};
+
+/* The index of the first key that equals an earlier one, or keys.size() if all are distinct */
+inline std::size_t find_duplicate_key(const std::vector<std::string_view>& keys) {
+	std::unordered_set<std::string_view> seen;
+
+	for (std::size_t k = 0; k < keys.size(); ++k) {
+		if (!seen.insert(keys[k]).second) {
+			return k;
+		}
+	}
+
+	return keys.size();
+}
+
+inline perfect_hash make_perfect_hash(const std::vector<std::string_view>& keys) {
+	/* Tried for a single bucket before the table is made larger */
+	constexpr std::uint32_t max_seed = 1u << 16;
+
+	/* With distinct keys, the first size practically always works */
+	constexpr int max_enlargements = 4;
+
+	if (const auto duplicate = find_duplicate_key(keys); duplicate != keys.size()) {
+		throw std::invalid_argument("Duplicate key in a perfect hash: " + std::string(keys[duplicate]));
+	}
+
+	std::size_t num_slots = 1;
+
+	while (num_slots < keys.size()) {
+		num_slots *= 2;
+	}
+
+	for (int enlargements = 0; enlargements <= max_enlargements; ++enlargements) {
+		const auto num_buckets = std::max(std::size_t(1), num_slots / 2);
+
+		perfect_hash out;
+		out.seeds.assign(num_buckets, 0);
+		out.slots.assign(num_slots, -1);
+
+		std::vector<std::vector<int>> buckets(num_buckets);
+
+		for (std::size_t k = 0; k < keys.size(); ++k) {
+			buckets[perfect_hash_string(keys[k], 0) & (num_buckets - 1)].push_back(static_cast<int>(k));
+		}
+
+		/* Largest buckets first, while there is the most room left */
+		std::vector<std::size_t> order(num_buckets);
+
+		for (std::size_t b = 0; b < num_buckets; ++b) {
+			order[b] = b;
+		}
+
+		std::stable_sort(order.begin(), order.end(), [&](const std::size_t a, const std::size_t b) {
+			return buckets[a].size() > buckets[b].size();
+		});
+
+		std::vector<std::size_t> bucket_slots;
+		bool all_placed = true;
+
+		for (const auto b : order) {
+			const auto& bucket = buckets[b];
+
+			if (bucket.empty()) {
+				break;
+			}
+
+			bool placed = false;
+
+			for (std::uint32_t seed = 1; seed < max_seed && !placed; ++seed) {
+				bucket_slots.clear();
+				placed = true;
+
+				for (const auto k : bucket) {
+					const auto slot = perfect_hash_string(keys[k], seed) & (num_slots - 1);
+
+					if (out.slots[slot] != -1 || std::find(bucket_slots.begin(), bucket_slots.end(), slot) != bucket_slots.end()) {
+						placed = false;
+						break;
+					}
+
+					bucket_slots.push_back(slot);
+				}
+
+				if (placed) {
+					out.seeds[b] = seed;
+
+					for (std::size_t i = 0; i < bucket.size(); ++i) {
+						out.slots[bucket_slots[i]] = bucket[i];
+					}
+				}
+			}
+
+			if (!placed) {
+				all_placed = false;
+				break;
+			}
+		}
+
+		if (all_placed) {
+			return out;
+		}
+
+		num_slots *= 2;
+	}
+
+	throw std::runtime_error("No perfect hash found for " + std::to_string(keys.size()) + " keys.");
+}
@@ -0,0 +1,405 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "perfect_hash.h"
+
+/*
+	The binary reflection schema written to reflection-schema-path, and a reader for it.
+	Tools may include this header together with perfect_hash.h, without the rest of the generator.
+
+	The file is a header followed by arrays of plain 32-bit fields in the byte order of the machine that generated it,
+	so a mapped file is used as it is: opening it costs no parsing and no allocations.
+	Every offset, range and index in the file is checked once when it is opened,
+	so that a corrupt or truncated file is rejected instead of being read out of bounds later.
+
+	header
+	types[num_types]                             - in the order of the generated introspectors
+	fields[num_fields]                           - the fields of every type in declaration order, enumerators for enums
+	template_arguments[num_template_arguments]
+	type_index, field_index                      - seeds and slots of two perfect hashes, see perfect_hash.h
+	strings                                      - names, not null-terminated
+
+	Types are found by their names as given after GEN INTROSPECTOR, e.g. "myn::EN3",
+	fields by the name of their type followed by "::" and their own name.
+	A name that is not in the schema may still land on a taken slot, so the reader compares the names as well.
+*/
+
+namespace reflection_schema_format {
+	/* "ISCH" when read in the byte order of the generating machine */
+	constexpr std::uint32_t magic = 0x48435349;
+	constexpr std::uint32_t version = 1;
+
+	/* Slots of the perfect hashes that no name maps to */
+	constexpr std::uint32_t empty_slot = 0xffffffff;
+
+	struct string_ref {
+		std::uint32_t offset;
+		std::uint32_t length;
+	};
+
+	struct hash_index {
+		std::uint32_t num_seeds;
+		std::uint32_t seeds_offset;
+		std::uint32_t num_slots;
+		std::uint32_t slots_offset;
+	};
+
+	struct header {
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t file_size;
+
+		std::uint32_t num_types;
+		std::uint32_t types_offset;
+
+		std::uint32_t num_fields;
+		std::uint32_t fields_offset;
+
+		std::uint32_t num_template_arguments;
+		std::uint32_t template_arguments_offset;
+
+		std::uint32_t strings_offset;
+		std::uint32_t strings_size;
+
+		hash_index type_index;
+		hash_index field_index;
+	};
+
+	enum class type_kind : std::uint32_t {
+		STRUCT,
+		CLASS,
+		ENUM,
+		ENUM_CLASS
+	};
+
+	struct type {
+		string_ref name;
+		type_kind kind;
+
+		std::uint32_t first_field;
+		std::uint32_t num_fields;
+
+		std::uint32_t first_template_argument;
+		std::uint32_t num_template_arguments;
+	};
+
+	/* Set for fields between preprocessor conditions, which may be compiled out */
+	constexpr std::uint32_t conditional_field = 1;
+
+	struct field {
+		string_ref name;
+
+		/* As written in the header; empty for enumerators */
+		string_ref type;
+
+		std::uint32_t owner;
+
+		/* Position in the declaration order, among the fields of the owner */
+		std::uint32_t index;
+
+		std::uint32_t flags;
+	};
+
+	struct template_argument {
+		/* e.g. "class" or "class..." */
+		string_ref kind;
+		string_ref name;
+	};
+}
+
+class reflection_schema {
+	using header = reflection_schema_format::header;
+
+#if defined(_WIN32)
+	std::string buffer;
+#else
+	void* mapping = nullptr;
+	std::size_t mapping_size = 0;
+#endif
+
+	const char* data = nullptr;
+	const header* h = nullptr;
+
+	template <class T>
+	const T* at(const std::uint32_t offset) const {
+		return reinterpret_cast<const T*>(data + offset);
+	}
+
+	template <class T>
+	bool fits(const std::size_t size, const std::uint32_t offset, const std::uint32_t count) const {
+		return offset % alignof(T) == 0 && offset <= size && count <= (size - offset) / sizeof(T);
+	}
+
+	bool validate(const std::size_t size) const {
+		if (size < sizeof(header)) {
+			return false;
+		}
+
+		const auto& hd = *reinterpret_cast<const header*>(data);
+
+		const auto is_power_of_two = [](const std::uint32_t n) {
+			return n > 0 && (n & (n - 1)) == 0;
+		};
+
+		const auto index_fits = [&](const reflection_schema_format::hash_index& i) {
+			return
+				is_power_of_two(i.num_seeds)
+				&& is_power_of_two(i.num_slots)
+				&& fits<std::uint32_t>(size, i.seeds_offset, i.num_seeds)
+				&& fits<std::uint32_t>(size, i.slots_offset, i.num_slots)
+			;
+		};
+
+		const bool sections_fit =
+			hd.magic == reflection_schema_format::magic
+			&& hd.version == reflection_schema_format::version
+			&& hd.file_size == size
+			&& fits<reflection_schema_format::type>(size, hd.types_offset, hd.num_types)
+			&& fits<reflection_schema_format::field>(size, hd.fields_offset, hd.num_fields)
+			&& fits<reflection_schema_format::template_argument>(size, hd.template_arguments_offset, hd.num_template_arguments)
+			&& fits<char>(size, hd.strings_offset, hd.strings_size)
+			&& index_fits(hd.type_index)
+			&& index_fits(hd.field_index)
+		;
+
+		if (!sections_fit) {
+			return false;
+		}
+
+		/* Now that the sections fit, check every reference within them */
+
+		const auto range_fits = [](const std::uint32_t first, const std::uint32_t count, const std::uint32_t total) {
+			return first <= total && count <= total - first;
+		};
+
+		const auto string_fits = [&](const reflection_schema_format::string_ref s) {
+			return range_fits(s.offset, s.length, hd.strings_size);
+		};
+
+		const auto slots_fit = [&](const reflection_schema_format::hash_index& i, const std::uint32_t count) {
+			const auto slots = at<std::uint32_t>(i.slots_offset);
+
+			for (std::uint32_t n = 0; n < i.num_slots; ++n) {
+				if (slots[n] != reflection_schema_format::empty_slot && slots[n] >= count) {
+					return false;
+				}
+			}
+
+			return true;
+		};
+
+		const auto types = at<reflection_schema_format::type>(hd.types_offset);
+
+		for (std::uint32_t n = 0; n < hd.num_types; ++n) {
+			const auto& t = types[n];
+
+			if (
+				!string_fits(t.name)
+				|| t.kind > reflection_schema_format::type_kind::ENUM_CLASS
+				|| !range_fits(t.first_field, t.num_fields, hd.num_fields)
+				|| !range_fits(t.first_template_argument, t.num_template_arguments, hd.num_template_arguments)
+			) {
+				return false;
+			}
+		}
+
+		const auto fields = at<reflection_schema_format::field>(hd.fields_offset);
+
+		for (std::uint32_t n = 0; n < hd.num_fields; ++n) {
+			const auto& f = fields[n];
+
+			if (!string_fits(f.name) || !string_fits(f.type) || f.owner >= hd.num_types) {
+				return false;
+			}
+		}
+
+		const auto template_arguments = at<reflection_schema_format::template_argument>(hd.template_arguments_offset);
+
+		for (std::uint32_t n = 0; n < hd.num_template_arguments; ++n) {
+			const auto& a = template_arguments[n];
+
+			if (!string_fits(a.kind) || !string_fits(a.name)) {
+				return false;
+			}
+		}
+
+		return slots_fit(hd.type_index, hd.num_types) && slots_fit(hd.field_index, hd.num_fields);
+	}
+
+	std::uint32_t lookup(
+		const reflection_schema_format::hash_index& i,
+		const std::initializer_list<std::string_view> key
+	) const {
+		const auto seeds = at<std::uint32_t>(i.seeds_offset);
+		const auto slots = at<std::uint32_t>(i.slots_offset);
+
+		const auto seed = seeds[perfect_hash_concatenation(key, 0) & (i.num_seeds - 1)];
+		return slots[perfect_hash_concatenation(key, seed) & (i.num_slots - 1)];
+	}
+
+	void release() {
+#if defined(_WIN32)
+		buffer.clear();
+#else
+		if (mapping != nullptr) {
+			::munmap(mapping, mapping_size);
+			mapping = nullptr;
+			mapping_size = 0;
+		}
+#endif
+		data = nullptr;
+		h = nullptr;
+	}
+
+public:
+	using type = reflection_schema_format::type;
+	using field = reflection_schema_format::field;
+	using template_argument = reflection_schema_format::template_argument;
+
+	reflection_schema() = default;
+
+	/* A file that could not be opened, or that is not a schema of this version, leaves the schema invalid */
+	explicit reflection_schema(const std::string& path) {
+		std::size_t size = 0;
+
+#if defined(_WIN32)
+		std::ifstream in(path, std::ios::in | std::ios::binary);
+		buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+		data = buffer.data();
+		size = buffer.size();
+#else
+		const auto fd = ::open(path.c_str(), O_RDONLY);
+
+		if (fd == -1) {
+			return;
+		}
+
+		struct stat st;
+
+		if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+			size = static_cast<std::size_t>(st.st_size);
+			const auto m = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+			if (m != MAP_FAILED) {
+				mapping = m;
+				mapping_size = size;
+				data = static_cast<const char*>(m);
+			}
+		}
+
+		::close(fd);
+#endif
+
+		if (data != nullptr && validate(size)) {
+			h = reinterpret_cast<const header*>(data);
+		}
+		else {
+			release();
+		}
+	}
+
+	reflection_schema(reflection_schema&& b) noexcept {
+		*this = std::move(b);
+	}
+
+	reflection_schema& operator=(reflection_schema&& b) noexcept {
+		if (this != &b) {
+			release();
+#if defined(_WIN32)
+			buffer = std::move(b.buffer);
+			data = b.h ? buffer.data() : nullptr;
+#else
+			mapping = b.mapping;
+			mapping_size = b.mapping_size;
+			data = b.data;
+
+			b.mapping = nullptr;
+			b.mapping_size = 0;
+#endif
+			h = data ? reinterpret_cast<const header*>(data) : nullptr;
+
+			b.data = nullptr;
+			b.h = nullptr;
+		}
+
+		return *this;
+	}
+
+	reflection_schema(const reflection_schema&) = delete;
+	reflection_schema& operator=(const reflection_schema&) = delete;
+
+	~reflection_schema() {
+		release();
+	}
+
+	bool valid() const {
+		return h != nullptr;
+	}
+
+	std::uint32_t num_types() const {
+		return h ? h->num_types : 0;
+	}
+
+	const type& get_type(const std::uint32_t i) const {
+		return at<type>(h->types_offset)[i];
+	}
+
+	/* The fields of a type are t.num_fields consecutive ones, starting at t.first_field */
+	const field& get_field(const std::uint32_t i) const {
+		return at<field>(h->fields_offset)[i];
+	}
+
+	const template_argument& get_template_argument(const std::uint32_t i) const {
+		return at<template_argument>(h->template_arguments_offset)[i];
+	}
+
+	std::string_view get_string(const reflection_schema_format::string_ref s) const {
+		return std::string_view(data + h->strings_offset + s.offset, s.length);
+	}
+
+	const type* find_type(const std::string_view name) const {
+		if (!h) {
+			return nullptr;
+		}
+
+		const auto i = lookup(h->type_index, { name });
+
+		if (i >= h->num_types) {
+			return nullptr;
+		}
+
+		const auto& t = get_type(i);
+		return get_string(t.name) == name ? &t : nullptr;
+	}
+
+	const field* find_field(const type& owner, const std::string_view name) const {
+		if (!h) {
+			return nullptr;
+		}
+
+		const auto i = lookup(h->field_index, { get_string(owner.name), "::", name });
+
+		if (i >= h->num_fields) {
+			return nullptr;
+		}
+
+		const auto& f = get_field(i);
+		return &get_type(f.owner) == &owner && get_string(f.name) == name ? &f : nullptr;
+	}
+};
@@ -0,0 +1,245 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "introspected_type.h"
+#include "scan_cache.h"
+#include "perfect_hash.h"
+#include "reflection_schema.h"
+
+/*
+	Builds the contents of the binary reflection schema, see reflection_schema.h for its layout.
+
+	Types come in the order of the headers, fields in declaration order.
+	Every string is stored once, however many fields share it, e.g. "int".
+	If two types share a name, only the first can be found by name, but both are listed.
+*/
+
+inline std::string make_reflection_schema(
+	const std::vector<std::string>& header_files,
+	const scan_cache& model
+) {
+	namespace format = reflection_schema_format;
+
+	std::string strings;
+	std::unordered_map<std::string, format::string_ref> string_refs;
+
+	auto add_string = [&](const std::string& s) {
+		const auto found = string_refs.find(s);
+
+		if (found != string_refs.end()) {
+			return found->second;
+		}
+
+		const auto ref = format::string_ref { static_cast<std::uint32_t>(strings.size()), static_cast<std::uint32_t>(s.size()) };
+
+		strings += s;
+		string_refs.emplace(s, ref);
+
+		return ref;
+	};
+
+	const auto get_kind = [](const introspected_type& t) {
+		const auto& k = t.struct_or_class_or_enum;
+
+		if (k == "enum class") {
+			return format::type_kind::ENUM_CLASS;
+		}
+
+		if (k == "enum") {
+			return format::type_kind::ENUM;
+		}
+
+		return k == "class" ? format::type_kind::CLASS : format::type_kind::STRUCT;
+	};
+
+	const auto is_directive = [](const std::string& line, const char* const directive) {
+		const auto hash = line.find_first_not_of(" \t");
+
+		if (hash == std::string::npos || line[hash] != '#') {
+			return false;
+		}
+
+		const auto name = line.find_first_not_of(" \t", hash + 1);
+		return name != std::string::npos && line.compare(name, std::strlen(directive), directive) == 0;
+	};
+
+	std::vector<format::type> types;
+	std::vector<format::field> fields;
+	std::vector<format::template_argument> template_arguments;
+
+	std::vector<std::string> type_keys;
+	std::vector<int> type_key_indices;
+
+	std::vector<std::string> field_keys;
+	std::vector<int> field_key_indices;
+
+	std::unordered_set<std::string> used_type_names;
+	std::unordered_set<std::string> used_field_keys;
+
+	for (const auto& path : header_files) {
+		const auto found = model.entries.find(path);
+
+		if (found == model.entries.end()) {
+			continue;
+		}
+
+		for (const auto& t : found->second.types) {
+			const auto type_index = static_cast<std::uint32_t>(types.size());
+			const bool findable = used_type_names.insert(t.type_name_without_templates).second;
+
+			if (findable) {
+				type_keys.push_back(t.type_name_without_templates);
+				type_key_indices.push_back(static_cast<int>(type_index));
+			}
+
+			format::type out;
+			out.name = add_string(t.type_name_without_templates);
+			out.kind = get_kind(t);
+			out.first_field = static_cast<std::uint32_t>(fields.size());
+			out.first_template_argument = static_cast<std::uint32_t>(template_arguments.size());
+			out.num_template_arguments = static_cast<std::uint32_t>(t.template_arguments.size());
+
+			for (const auto& a : t.template_arguments) {
+				template_arguments.push_back({ add_string(a.first), add_string(a.second) });
+			}
+
+			/* #else and #elif stay within the same condition */
+			int condition_depth = 0;
+			std::uint32_t field_index = 0;
+
+			for (const auto& l : t.lines) {
+				if (l.type == block_line_type::INTACT) {
+					if (is_directive(l.text, "if")) {
+						++condition_depth;
+					}
+					else if (is_directive(l.text, "endif") && condition_depth > 0) {
+						--condition_depth;
+					}
+
+					continue;
+				}
+
+				if (findable) {
+					auto key = t.type_name_without_templates + "::" + l.text;
+
+					if (used_field_keys.insert(key).second) {
+						field_keys.push_back(std::move(key));
+						field_key_indices.push_back(static_cast<int>(fields.size()));
+					}
+				}
+
+				format::field f;
+				f.name = add_string(l.text);
+				f.type = add_string(l.field_type);
+				f.owner = type_index;
+				f.index = field_index++;
+				f.flags = condition_depth > 0 ? format::conditional_field : 0;
+
+				fields.push_back(f);
+			}
+
+			out.num_fields = field_index;
+			types.push_back(out);
+		}
+	}
+
+	const auto make_index = [](const std::vector<std::string>& keys, const std::vector<int>& key_indices) {
+		std::vector<std::string_view> views(keys.begin(), keys.end());
+
+		/* The keys are distinct by now, see used_type_names and used_field_keys */
+		if (const auto duplicate = find_duplicate_key(views); duplicate != views.size()) {
+			throw header_parse_error(typesafe_sprintf(
+				"%x appears more than once in the reflection schema.\n",
+				views[duplicate]
+			));
+		}
+
+		perfect_hash hash;
+
+		try {
+			hash = make_perfect_hash(views);
+		}
+		catch (const std::runtime_error& err) {
+			throw header_parse_error(std::string("Cannot index the reflection schema. ") + err.what() + "\n");
+		}
+
+		for (auto& s : hash.slots) {
+			s = s == -1 ? -1 : key_indices[s];
+		}
+
+		return hash;
+	};
+
+	const auto type_hash = make_index(type_keys, type_key_indices);
+	const auto field_hash = make_index(field_keys, field_key_indices);
+
+	format::header h;
+	std::memset(&h, 0, sizeof(h));
+
+	h.magic = format::magic;
+	h.version = format::version;
+
+	std::uint32_t offset = sizeof(format::header);
+
+	auto place = [&](std::uint32_t& at, const std::size_t count, const std::size_t size) {
+		at = offset;
+		offset += static_cast<std::uint32_t>(count * size);
+	};
+
+	h.num_types = static_cast<std::uint32_t>(types.size());
+	place(h.types_offset, types.size(), sizeof(format::type));
+
+	h.num_fields = static_cast<std::uint32_t>(fields.size());
+	place(h.fields_offset, fields.size(), sizeof(format::field));
+
+	h.num_template_arguments = static_cast<std::uint32_t>(template_arguments.size());
+	place(h.template_arguments_offset, template_arguments.size(), sizeof(format::template_argument));
+
+	auto place_index = [&](format::hash_index& i, const perfect_hash& hash) {
+		i.num_seeds = static_cast<std::uint32_t>(hash.seeds.size());
+		place(i.seeds_offset, hash.seeds.size(), sizeof(std::uint32_t));
+
+		i.num_slots = static_cast<std::uint32_t>(hash.slots.size());
+		place(i.slots_offset, hash.slots.size(), sizeof(std::uint32_t));
+	};
+
+	place_index(h.type_index, type_hash);
+	place_index(h.field_index, field_hash);
+
+	h.strings_size = static_cast<std::uint32_t>(strings.size());
+	place(h.strings_offset, strings.size(), 1);
+
+	h.file_size = offset;
+
+	std::string out;
+	out.reserve(offset);
+
+	auto append = [&](const void* const data, const std::size_t size) {
+		out.append(static_cast<const char*>(data), size);
+	};
+
+	auto append_index = [&](const perfect_hash& hash) {
+		append(hash.seeds.data(), hash.seeds.size() * sizeof(std::uint32_t));
+
+		for (const auto s : hash.slots) {
+			const auto slot = s == -1 ? format::empty_slot : static_cast<std::uint32_t>(s);
+			append(&slot, sizeof(slot));
+		}
+	};
+
+	append(&h, sizeof(h));
+	append(types.data(), types.size() * sizeof(format::type));
+	append(fields.data(), fields.size() * sizeof(format::field));
+	append(template_arguments.data(), template_arguments.size() * sizeof(format::template_argument));
+	append_index(type_hash);
+	append_index(field_hash);
+	out += strings;
+
+	return out;
+}
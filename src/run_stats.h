@@ -0,0 +1,260 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+	Timings and counters of a single run, enabled with --stats or --trace.
+
+	Every stage of the pipeline takes an optional run_stats*, and does no extra work when it is null.
+	Time spent in each phase is summed across all threads,
+	so with more than one job the scanning phases may add up to more than the wall time.
+
+	Coarse spans - the stages themselves, and reading and parsing each header - are also kept
+	as Chrome trace events, viewable in chrome://tracing or https://ui.perfetto.dev.
+	Marker scanning, output writes and output comparisons happen in many tiny steps,
+	so they are only summed up.
+*/
+
+enum class run_phase {
+	CONFIGURATION,
+	DIRECTORY_WALK,
+	CACHE_LOAD,
+	FILE_READ,
+	MARKER_SCAN,
+	FIELD_PARSE,
+	FORMAT,
+	OUTPUT_WRITE,
+	OUTPUT_COMPARE,
+	CACHE_SAVE,
+
+	COUNT
+};
+
+inline const char* get_phase_name(const run_phase p) {
+	switch (p) {
+		case run_phase::CONFIGURATION: return "configuration";
+		case run_phase::DIRECTORY_WALK: return "directory walk";
+		case run_phase::CACHE_LOAD: return "scan cache load";
+		case run_phase::FILE_READ: return "file read";
+		case run_phase::MARKER_SCAN: return "marker scan";
+		case run_phase::FIELD_PARSE: return "field parse";
+		case run_phase::FORMAT: return "format";
+		case run_phase::OUTPUT_WRITE: return "output write";
+		case run_phase::OUTPUT_COMPARE: return "output compare";
+		case run_phase::CACHE_SAVE: return "scan cache save";
+		default: return "unknown";
+	}
+}
+
+class run_stats {
+public:
+	using clock = std::chrono::steady_clock;
+
+	struct trace_event {
+		std::string name;
+		std::string detail;
+		std::size_t thread_index = 0;
+		std::int64_t start_us = 0;
+		std::int64_t duration_us = 0;
+	};
+
+private:
+	const clock::time_point start = clock::now();
+	const bool keep_trace;
+
+	std::atomic<std::int64_t> phase_ns[static_cast<std::size_t>(run_phase::COUNT)] = {};
+
+	std::mutex trace_lock;
+	std::vector<trace_event> trace;
+	std::atomic<std::size_t> next_thread_index = 0;
+
+	std::size_t get_thread_index() {
+		thread_local const run_stats* owner = nullptr;
+		thread_local std::size_t index = 0;
+
+		if (owner != this) {
+			owner = this;
+			index = next_thread_index++;
+		}
+
+		return index;
+	}
+
+	std::int64_t to_us(const clock::time_point t) const {
+		return std::chrono::duration_cast<std::chrono::microseconds>(t - start).count();
+	}
+
+	static void write_json_string(std::ostream& out, const std::string& s) {
+		out << '"';
+
+		for (const auto c : s) {
+			if (c == '"' || c == '\\') {
+				out << '\\' << c;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20) {
+				out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+			}
+			else {
+				out << c;
+			}
+		}
+
+		out << '"';
+	}
+
+public:
+	std::atomic<std::size_t> header_files = 0;
+	std::atomic<std::size_t> headers_read = 0;
+	std::atomic<std::size_t> headers_parsed = 0;
+	std::atomic<std::uint64_t> bytes_read = 0;
+	std::atomic<std::size_t> annotated_types = 0;
+	std::atomic<std::size_t> fields = 0;
+
+	std::atomic<std::size_t> outputs_replaced = 0;
+	std::atomic<std::size_t> outputs_unchanged = 0;
+	std::atomic<std::uint64_t> bytes_generated = 0;
+
+	explicit run_stats(const bool keep_trace) : keep_trace(keep_trace) {}
+
+	void add_time(const run_phase p, const clock::duration d) {
+		phase_ns[static_cast<std::size_t>(p)] += std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+	}
+
+	double get_ms(const run_phase p) const {
+		return phase_ns[static_cast<std::size_t>(p)] / 1e6;
+	}
+
+	void add_trace_event(std::string name, std::string detail, const clock::time_point from, const clock::time_point to) {
+		if (!keep_trace) {
+			return;
+		}
+
+		trace_event e;
+		e.name = std::move(name);
+		e.detail = std::move(detail);
+		e.thread_index = get_thread_index();
+		e.start_us = to_us(from);
+		e.duration_us = std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+
+		std::lock_guard<std::mutex> lock(trace_lock);
+		trace.emplace_back(std::move(e));
+	}
+
+	void print(std::ostream& out) const {
+		out << "Stats:" << std::endl;
+
+		for (std::size_t p = 0; p < static_cast<std::size_t>(run_phase::COUNT); ++p) {
+			const auto phase = static_cast<run_phase>(p);
+
+			out << "  " << std::left << std::setw(18) << get_phase_name(phase) << std::right
+				<< std::fixed << std::setprecision(3) << std::setw(12) << get_ms(phase) << " ms" << std::endl;
+		}
+
+		out << "  Header files: " << header_files << " (read: " << headers_read << ", parsed: " << headers_parsed << ")" << std::endl;
+		out << "  Bytes read: " << bytes_read << std::endl;
+		out << "  Annotated types: " << annotated_types << std::endl;
+		out << "  Fields: " << fields << std::endl;
+		out << "  Outputs replaced: " << outputs_replaced << ", unchanged: " << outputs_unchanged << std::endl;
+		out << "  Bytes generated: " << bytes_generated << std::endl;
+	}
+
+	/* Writes the trace in the Chrome trace event format, with the totals as counter events at the end. */
+
+	void write_trace(const std::string& path) {
+		std::ofstream out(path, std::ios::out | std::ios::binary);
+
+		std::lock_guard<std::mutex> lock(trace_lock);
+
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		for (const auto& e : trace) {
+			out << "{\"name\":";
+			write_json_string(out, e.name);
+			out << ",\"cat\":\"generator\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread_index
+				<< ",\"ts\":" << e.start_us << ",\"dur\":" << e.duration_us;
+
+			if (!e.detail.empty()) {
+				out << ",\"args\":{\"path\":";
+				write_json_string(out, e.detail);
+				out << "}";
+			}
+
+			out << "},\n";
+		}
+
+		const auto end_us = to_us(clock::now());
+
+		out << "{\"name\":\"phase time (ms)\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":" << end_us << ",\"args\":{";
+
+		for (std::size_t p = 0; p < static_cast<std::size_t>(run_phase::COUNT); ++p) {
+			const auto phase = static_cast<run_phase>(p);
+
+			out << (p > 0 ? "," : "");
+			write_json_string(out, get_phase_name(phase));
+			out << ":" << std::fixed << std::setprecision(3) << get_ms(phase);
+		}
+
+		out << "}},\n";
+
+		out << "{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":" << end_us << ",\"args\":{"
+			<< "\"header files\":" << header_files
+			<< ",\"headers read\":" << headers_read
+			<< ",\"headers parsed\":" << headers_parsed
+			<< ",\"bytes read\":" << bytes_read
+			<< ",\"annotated types\":" << annotated_types
+			<< ",\"fields\":" << fields
+			<< ",\"outputs replaced\":" << outputs_replaced
+			<< ",\"outputs unchanged\":" << outputs_unchanged
+			<< ",\"bytes generated\":" << bytes_generated
+			<< "}}\n]}\n";
+	}
+};
+
+/*
+	Adds the time until the end of the scope to a phase of run_stats, if there is one.
+	If given a trace name, the span also ends up in the trace.
+*/
+
+class run_stats_scope {
+	run_stats* const stats;
+	const run_phase phase;
+	const char* const trace_name;
+	const std::string* const trace_detail;
+	const run_stats::clock::time_point start;
+
+public:
+	run_stats_scope(
+		run_stats* const stats,
+		const run_phase phase,
+		const char* const trace_name = nullptr,
+		const std::string* const trace_detail = nullptr
+	) :
+		stats(stats),
+		phase(phase),
+		trace_name(trace_name),
+		trace_detail(trace_detail),
+		start(stats ? run_stats::clock::now() : run_stats::clock::time_point())
+	{}
+
+	run_stats_scope(const run_stats_scope&) = delete;
+	run_stats_scope& operator=(const run_stats_scope&) = delete;
+
+	~run_stats_scope() {
+		if (stats) {
+			const auto end = run_stats::clock::now();
+
+			stats->add_time(phase, end - start);
+
+			if (trace_name) {
+				stats->add_trace_event(trace_name, trace_detail ? *trace_detail : std::string(), start, end);
+			}
+		}
+	}
+};
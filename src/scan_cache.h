@@ -0,0 +1,355 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "spellbook.h"
+#include "introspected_type.h"
+#include "mapped_file.h"
+#include "output_writer.h"
+#include "run_stats.h"
+
+/*
+	Persistent per-header scan cache.
+
+	For every scanned header we remember its size, modification time and content hash,
+	together with the GEN INTROSPECTOR blocks parsed out of it.
+	A header whose size and mtime did not change is not even opened on the next run;
+	a header that was touched but whose contents hash the same is not parsed again.
+
+	The parsed blocks do not depend on the output formats, only on the markers,
+	so the cache is invalidated only when beginning-line or ending-line change.
+*/
+
+struct scan_cache_entry {
+	std::uint64_t size = 0;
+	std::int64_t mtime = 0;
+	std::uint64_t hash = 0;
+	introspected_types types;
+};
+
+struct scan_cache {
+	static constexpr std::uint32_t version = 10;
+
+	std::string beginning_line;
+	std::string ending_line;
+	std::unordered_map<std::string, scan_cache_entry> entries;
+
+	/* Generated files as of the last time they were written */
+	std::unordered_map<std::string, output_record> outputs;
+
+	/*
+		Shards written by the last run in the sharded mode.
+		Only these are ever removed, since the shard directory may hold other files,
+		or the shards of another configuration.
+	*/
+	std::vector<std::string> shards;
+};
+
+namespace scan_cache_io {
+	template <class T>
+	void write_pod(std::ostream& out, const T& value) {
+		out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template <class T>
+	void read_pod(std::istream& in, T& value) {
+		in.read(reinterpret_cast<char*>(&value), sizeof(T));
+
+		if (!in) {
+			throw std::runtime_error("Truncated scan cache.");
+		}
+	}
+
+	inline void write_string(std::ostream& out, const std::string& s) {
+		write_pod(out, static_cast<std::uint64_t>(s.size()));
+		out.write(s.data(), s.size());
+	}
+
+	inline void read_string(std::istream& in, std::string& s) {
+		std::uint64_t size = 0;
+		read_pod(in, size);
+		s.resize(static_cast<std::size_t>(size));
+		in.read(s.data(), size);
+
+		if (!in) {
+			throw std::runtime_error("Truncated scan cache.");
+		}
+	}
+
+	inline void write_type(std::ostream& out, const introspected_type& t) {
+		write_string(out, t.struct_or_class_or_enum);
+		write_string(out, t.type_name_without_templates);
+
+		write_pod(out, static_cast<std::uint64_t>(t.template_arguments.size()));
+
+		for (const auto& a : t.template_arguments) {
+			write_string(out, a.first);
+			write_string(out, a.second);
+		}
+
+		write_pod(out, static_cast<std::uint64_t>(t.lines.size()));
+
+		for (const auto& l : t.lines) {
+			write_pod(out, l.type);
+			write_string(out, l.text);
+			write_string(out, l.field_type);
+			write_pod(out, l.tags);
+		}
+
+		write_pod(out, static_cast<std::uint64_t>(t.tag_names.size()));
+
+		for (const auto& tag : t.tag_names) {
+			write_string(out, tag);
+		}
+	}
+
+	inline void read_type(std::istream& in, introspected_type& t) {
+		read_string(in, t.struct_or_class_or_enum);
+		read_string(in, t.type_name_without_templates);
+
+		std::uint64_t count = 0;
+
+		read_pod(in, count);
+		t.template_arguments.resize(static_cast<std::size_t>(count));
+
+		for (auto& a : t.template_arguments) {
+			read_string(in, a.first);
+			read_string(in, a.second);
+		}
+
+		read_pod(in, count);
+		t.lines.resize(static_cast<std::size_t>(count));
+
+		for (auto& l : t.lines) {
+			read_pod(in, l.type);
+			read_string(in, l.text);
+			read_string(in, l.field_type);
+			read_pod(in, l.tags);
+		}
+
+		read_pod(in, count);
+		t.tag_names.resize(static_cast<std::size_t>(count));
+
+		for (auto& tag : t.tag_names) {
+			read_string(in, tag);
+		}
+	}
+}
+
+inline std::string get_scan_cache_path(const std::string& generated_file_path) {
+	return generated_file_path + ".cache";
+}
+
+/*
+	Returns an empty cache if the file is missing, corrupt, of another version
+	or was produced with different markers.
+*/
+
+inline scan_cache load_scan_cache(
+	const std::string& path,
+	const std::string& beginning_line,
+	const std::string& ending_line
+) {
+	using namespace scan_cache_io;
+
+	scan_cache result;
+	result.beginning_line = beginning_line;
+	result.ending_line = ending_line;
+
+	std::ifstream in(path, std::ios::in | std::ios::binary);
+
+	if (!in) {
+		return result;
+	}
+
+	try {
+		std::uint32_t version = 0;
+		read_pod(in, version);
+
+		if (version != scan_cache::version) {
+			return result;
+		}
+
+		std::string cached_beginning_line;
+		std::string cached_ending_line;
+
+		read_string(in, cached_beginning_line);
+		read_string(in, cached_ending_line);
+
+		if (cached_beginning_line != beginning_line || cached_ending_line != ending_line) {
+			return result;
+		}
+
+		std::uint64_t num_entries = 0;
+		read_pod(in, num_entries);
+
+		for (std::uint64_t e = 0; e < num_entries; ++e) {
+			std::string header_path;
+			scan_cache_entry entry;
+
+			read_string(in, header_path);
+			read_pod(in, entry.size);
+			read_pod(in, entry.mtime);
+			read_pod(in, entry.hash);
+
+			std::uint64_t num_types = 0;
+			read_pod(in, num_types);
+			entry.types.resize(static_cast<std::size_t>(num_types));
+
+			for (auto& t : entry.types) {
+				read_type(in, t);
+			}
+
+			result.entries[header_path] = std::move(entry);
+		}
+
+		std::uint64_t num_outputs = 0;
+		read_pod(in, num_outputs);
+
+		for (std::uint64_t o = 0; o < num_outputs; ++o) {
+			std::string output_path;
+			output_record record;
+
+			read_string(in, output_path);
+			read_pod(in, record.size);
+			read_pod(in, record.mtime);
+			read_pod(in, record.content_hash);
+
+			result.outputs[output_path] = record;
+		}
+
+		std::uint64_t num_shards = 0;
+		read_pod(in, num_shards);
+		result.shards.resize(static_cast<std::size_t>(num_shards));
+
+		for (auto& shard : result.shards) {
+			read_string(in, shard);
+		}
+	}
+	catch (...) {
+		result.entries.clear();
+		result.outputs.clear();
+		result.shards.clear();
+	}
+
+	return result;
+}
+
+inline void save_scan_cache(
+	const std::string& path,
+	const scan_cache& cache
+) {
+	using namespace scan_cache_io;
+
+	std::ofstream out(path, std::ios::out | std::ios::binary);
+
+	write_pod(out, scan_cache::version);
+	write_string(out, cache.beginning_line);
+	write_string(out, cache.ending_line);
+	write_pod(out, static_cast<std::uint64_t>(cache.entries.size()));
+
+	for (const auto& e : cache.entries) {
+		write_string(out, e.first);
+		write_pod(out, e.second.size);
+		write_pod(out, e.second.mtime);
+		write_pod(out, e.second.hash);
+		write_pod(out, static_cast<std::uint64_t>(e.second.types.size()));
+
+		for (const auto& t : e.second.types) {
+			write_type(out, t);
+		}
+	}
+
+	write_pod(out, static_cast<std::uint64_t>(cache.outputs.size()));
+
+	for (const auto& o : cache.outputs) {
+		write_string(out, o.first);
+		write_pod(out, o.second.size);
+		write_pod(out, o.second.mtime);
+		write_pod(out, o.second.content_hash);
+	}
+
+	write_pod(out, static_cast<std::uint64_t>(cache.shards.size()));
+
+	for (const auto& shard : cache.shards) {
+		write_string(out, shard);
+	}
+}
+
+/*
+	Produces the up-to-date entry for a header,
+	reusing the one from the previous run whenever possible.
+	Throws header_parse_error on bad syntax.
+	allow_mapping = false reads the header with plain reads, see mapped_file.
+*/
+
+inline scan_cache_entry scan_header(
+	const std::string& path,
+	const scan_cache& previous,
+	run_stats* const stats = nullptr,
+	const bool allow_mapping = true
+) {
+	scan_cache_entry entry;
+
+	std::error_code err;
+
+	const auto size = fs::file_size(path, err);
+
+	if (err) {
+		/* Nonexistent headers are simply empty, just like before */
+		return entry;
+	}
+
+	entry.size = static_cast<std::uint64_t>(size);
+	entry.mtime = get_mtime(path, err);
+
+	const auto found = previous.entries.find(path);
+	const auto* const cached = found != previous.entries.end() ? std::addressof(found->second) : nullptr;
+
+	if (cached && !err && cached->size == entry.size && cached->mtime == entry.mtime) {
+		return *cached;
+	}
+
+	const auto read_start = stats ? run_stats::clock::now() : run_stats::clock::time_point();
+
+	const auto file = mapped_file(path, allow_mapping);
+	const auto contents = file.contents();
+
+	entry.hash = fnv1a_64(contents.data(), contents.size());
+
+	if (stats) {
+		const auto read_end = run_stats::clock::now();
+
+		stats->add_time(run_phase::FILE_READ, read_end - read_start);
+		stats->add_trace_event("read", path, read_start, read_end);
+
+		++stats->headers_read;
+		stats->bytes_read += contents.size();
+	}
+
+	if (cached && cached->size == entry.size && cached->hash == entry.hash) {
+		entry.types = cached->types;
+		return entry;
+	}
+
+	const auto parse_start = stats ? run_stats::clock::now() : run_stats::clock::time_point();
+
+	entry.types = parse_introspected_types(
+		contents,
+		path,
+		previous.beginning_line,
+		previous.ending_line,
+		stats
+	);
+
+	if (stats) {
+		stats->add_trace_event("parse", path, parse_start, run_stats::clock::now());
+		++stats->headers_parsed;
+	}
+
+	return entry;
+}
@@ -1,9 +1,13 @@
 #pragma once
 #include <type_traits>
+#include <cstdint>
+#include <iostream>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <fstream>
 #include <filesystem>
+#include <algorithm>
 #include <limits>
 #include <vector>
 
@@ -115,7 +119,16 @@ auto typesafe_sprintf(const wchar_t* const c_str, A&&... a) {
 
 namespace fs = std::filesystem;
 
-auto get_file_lines(const std::string& filename) {
+inline std::uint64_t fnv1a_64(const char* const data, const std::size_t size, std::uint64_t hash = 0xcbf29ce484222325ull) {
+	for (std::size_t i = 0; i < size; ++i) {
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+inline auto get_file_lines(const std::string& filename) {
 	std::ifstream input(filename);
 
 	std::vector<std::string> out;
@@ -127,12 +140,31 @@ auto get_file_lines(const std::string& filename) {
 	return out;
 }
 
-void debugbreak() {
+/* Splits exactly like get_file_lines does */
+
+inline auto get_string_lines(const std::string_view contents) {
+	std::vector<std::string> out;
+
+	for (std::size_t offset = 0; offset < contents.size(); ) {
+		auto end = contents.find('\n', offset);
+
+		if (end == std::string_view::npos) {
+			end = contents.size();
+		}
+
+		out.emplace_back(contents.substr(offset, end - offset));
+		offset = end + 1;
+	}
+
+	return out;
+}
+
+inline void debugbreak() {
 	std::getchar();
 	exit(0);
 }
 
-std::string file_to_string(std::string path) {
+inline std::string file_to_string(std::string path) {
 	if (!fs::exists(path)) {
 		std::cout << typesafe_sprintf("File %x does not exist!", path);
 		debugbreak();
@@ -151,35 +183,17 @@ void create_text_file(const T& filename, const T& text) {
 	out << text;
 }
 
-auto make_get_line_until(
-	const std::vector<std::string>& lines,
-	size_t& current_line
-) {
-	return [&lines, &current_line](const std::string delimiter = std::string()) {
-		if (!(current_line < lines.size())) {
-			return false;
-		}
-		
-		if ((!delimiter.empty() && lines[current_line] == delimiter)) {
-			++current_line;
-			return false;
-		}
-		
-		return true;
-	};
-}
-
 template <typename... A>
 void LOG(const std::string& f, A&&... a) {
 	LOG(typesafe_sprintf(f, std::forward<A>(a)...));
 }
 
 template <>
-void LOG(const std::string& f) {
+inline void LOG(const std::string& f) {
 	std::cout << f;
 }
 
-auto lines_to_string(
+inline auto lines_to_string(
 	const std::vector<std::string>& lines
 ) {
 	std::string output;
@@ -191,45 +205,46 @@ auto lines_to_string(
 	return output;
 }
 
-auto break_lines_by_properties(
+/*
+	Required properties must appear in the given order.
+	Optional properties may appear anywhere after the first one, and are left empty when absent.
+	The contents of the required properties come first in the result, followed by the optional ones.
+*/
+
+inline auto break_lines_by_properties(
 	const std::vector<std::string>& lines,
-	const std::vector<std::string>& properties
+	const std::vector<std::string>& properties,
+	const std::vector<std::string>& optional_properties = {}
 ) {
 	std::vector<std::vector<std::string>> lines_per_property;
 
 	if (properties.size() > 0 && lines.size() > 0) {
-		std::size_t i = 0;
-		std::size_t p = 0;
-
-		auto get_line_until = make_get_line_until(lines, i);
+		lines_per_property.resize(properties.size() + optional_properties.size());
 
-		const bool first_property_name_matches = lines[i++] == properties[p++];
-
-		if (!first_property_name_matches) {
-			throw std::exception();
-		}
-
-		for (; p < properties.size(); ++p) {
-			std::vector<std::string> new_property_content;
+		std::size_t p = 0;
+		std::vector<std::string>* current_property_content = nullptr;
 
-			while (get_line_until(properties[p])) {
-				new_property_content.push_back(lines[i++]);
+		for (const auto& l : lines) {
+			if (p < properties.size() && l == properties[p]) {
+				current_property_content = &lines_per_property[p++];
+				continue;
 			}
 
-			lines_per_property.push_back(new_property_content);
-		}
+			const auto found_optional = std::find(optional_properties.begin(), optional_properties.end(), l);
 
-		{
-			std::vector<std::string> new_property_content;
+			if (found_optional != optional_properties.end()) {
+				current_property_content = &lines_per_property[properties.size() + (found_optional - optional_properties.begin())];
+				continue;
+			}
 
-			while(get_line_until()) {
-				new_property_content.push_back(lines[i++]);
+			if (current_property_content == nullptr) {
+				throw std::exception();
 			}
 
-			lines_per_property.push_back(new_property_content);
+			current_property_content->push_back(l);
 		}
 
-		if (lines_per_property.size() != properties.size()) {
+		if (p != properties.size()) {
 			throw std::exception();
 		}
 	}
@@ -0,0 +1,202 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "spellbook.h"
+#include "introspected_type.h"
+#include "scan_cache.h"
+#include "type_reachability.h"
+
+/*
+	Structural hashes, so that a loader can tell by a single value whether a type still has the shape it was saved with.
+
+	The hash of a field is 64-bit FNV-1a over its name, its type as written,
+	and the hashes of the introspected types that its type names, found the same way as for root-types.
+	The hash of a type is then made in the generated code from the hashes of its fields,
+	so that fields between preprocessor conditions count only where they are compiled in.
+
+	The introspected types named in a field's type are hashed as declared,
+	over their fields and any preprocessor lines between them.
+	Types that refer to each other, e.g. a node with a vector of nodes,
+	mix only each other's names, so that a hash never depends on the order in which the headers were found.
+
+	The ID of a field is the low 32 bits of FNV-1a over its name,
+	so it stays the same wherever the field is moved, and changes only when the field is renamed.
+	Two differently named fields of one type could still get the same ID,
+	which is then reported like bad syntax, so that one of them can be renamed.
+*/
+
+inline std::uint32_t make_field_id(const std::string& name) {
+	return static_cast<std::uint32_t>(fnv1a_64(name.data(), name.size()));
+}
+
+/* Throws header_parse_error if two fields of a type have the same ID */
+
+inline void check_field_ids(
+	const std::vector<std::string>& header_files,
+	const scan_cache& model
+) {
+	std::unordered_map<std::uint32_t, const std::string*> names_by_id;
+
+	for (const auto& path : header_files) {
+		const auto found = model.entries.find(path);
+
+		if (found == model.entries.end()) {
+			continue;
+		}
+
+		for (const auto& t : found->second.types) {
+			if (t.is_enum()) {
+				continue;
+			}
+
+			names_by_id.clear();
+
+			for (const auto& l : t.lines) {
+				if (l.type == block_line_type::INTACT) {
+					continue;
+				}
+
+				const auto id = make_field_id(l.text);
+				const auto inserted = names_by_id.emplace(id, &l.text);
+
+				/* The same field may be declared in several preprocessor branches */
+				if (!inserted.second && *inserted.first->second != l.text) {
+					throw header_parse_error(typesafe_sprintf(
+						"Fields %x and %x of %x in file %x have the same field ID %x. Rename one of them.\n",
+						*inserted.first->second,
+						l.text,
+						t.type_name_without_templates,
+						path,
+						id
+					));
+				}
+			}
+		}
+	}
+}
+
+struct structural_hashes {
+	/* Per type, the hashes of its fields in declaration order */
+	std::unordered_map<const introspected_type*, std::vector<std::uint64_t>> field_hashes;
+};
+
+inline structural_hashes make_structural_hashes(
+	const std::vector<std::string>& header_files,
+	const scan_cache& model
+) {
+	check_field_ids(header_files, model);
+
+	const auto types = gather_introspected_types(header_files, model);
+	const auto names = type_name_index(types);
+
+	/* Tarjan's algorithm, which finishes every group of mutually referring types after all the groups it refers to */
+
+	const auto n = types.size();
+	const auto unvisited = static_cast<std::size_t>(-1);
+
+	std::vector<std::size_t> order(n, unvisited);
+	std::vector<std::size_t> low(n, 0);
+	std::vector<bool> on_stack(n, false);
+	std::vector<std::size_t> stack;
+	std::vector<std::size_t> group(n, 0);
+
+	std::size_t next_order = 0;
+	std::size_t num_groups = 0;
+
+	std::vector<std::uint64_t> type_hashes(n, 0);
+
+	structural_hashes out;
+
+	const auto mix = [](const std::uint64_t hash, const std::uint64_t value) {
+		return fnv1a_64(reinterpret_cast<const char*>(&value), sizeof(value), hash);
+	};
+
+	const auto hash_string = [](const std::string_view s, const std::uint64_t hash = 0xcbf29ce484222325ull) {
+		/* A zero after every string keeps "ab", "c" apart from "a", "bc" */
+		const char terminator = 0;
+		return fnv1a_64(&terminator, 1, fnv1a_64(s.data(), s.size(), hash));
+	};
+
+	auto hash_group = [&](const std::size_t g, const std::vector<std::size_t>& members) {
+		for (const auto i : members) {
+			const auto& t = *types[i];
+			auto& field_hashes = out.field_hashes[&t];
+
+			auto type_hash = hash_string(t.struct_or_class_or_enum);
+
+			for (const auto& l : t.lines) {
+				if (l.type == block_line_type::INTACT) {
+					const auto begin = l.text.find_first_not_of(" \t\r");
+
+					if (begin != std::string::npos) {
+						const auto end = l.text.find_last_not_of(" \t\r");
+						type_hash = hash_string(std::string_view(l.text).substr(begin, end - begin + 1), type_hash);
+					}
+
+					continue;
+				}
+
+				auto field_hash = hash_string(l.field_type, hash_string(l.text));
+
+				names.for_each_referenced(l.field_type, [&](const std::size_t j) {
+					field_hash = group[j] == g ? hash_string(types[j]->type_name_without_templates, field_hash) : mix(field_hash, type_hashes[j]);
+				});
+
+				field_hashes.push_back(field_hash);
+				type_hash = mix(type_hash, field_hash);
+			}
+
+			type_hashes[i] = type_hash;
+		}
+	};
+
+	auto visit = [&](auto& self, const std::size_t i) -> void {
+		order[i] = low[i] = next_order++;
+		stack.push_back(i);
+		on_stack[i] = true;
+
+		for (const auto& l : types[i]->lines) {
+			names.for_each_referenced(l.field_type, [&](const std::size_t j) {
+				if (order[j] == unvisited) {
+					self(self, j);
+					low[i] = std::min(low[i], low[j]);
+				}
+				else if (on_stack[j]) {
+					low[i] = std::min(low[i], order[j]);
+				}
+			});
+		}
+
+		if (low[i] == order[i]) {
+			std::vector<std::size_t> members;
+
+			while (true) {
+				const auto j = stack.back();
+				stack.pop_back();
+				on_stack[j] = false;
+
+				group[j] = num_groups;
+				members.push_back(j);
+
+				if (j == i) {
+					break;
+				}
+			}
+
+			hash_group(num_groups++, members);
+		}
+	};
+
+	for (std::size_t i = 0; i < n; ++i) {
+		if (order[i] == unvisited) {
+			visit(visit, i);
+		}
+	}
+
+	return out;
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include "spellbook.h"
+
+/*
+	Writes a deterministic corpus of annotated headers, modeled on example/example_classes:
+	plain, templated and namespaced structs, enums, preprocessor lines inside the blocks,
+	and ordinary code around them that the generator has to skip.
+
+	Used by the benchmark to measure the generator on corpora of any size.
+*/
+
+struct synthetic_corpus_settings {
+	std::size_t num_headers = 200;
+	std::size_t structs_per_header = 4;
+	std::size_t enums_per_header = 1;
+	std::size_t fields_per_struct = 8;
+	std::size_t enumerators_per_enum = 8;
+
+	/* Every n-th struct is a template, every n-th type is in a namespace. 0 disables either. */
+	std::size_t template_every = 3;
+	std::size_t namespace_every = 2;
+
+	std::size_t headers_per_directory = 64;
+};
+
+struct synthetic_corpus_stats {
+	std::size_t num_headers = 0;
+	std::size_t num_types = 0;
+	std::size_t num_fields = 0;
+	std::uintmax_t num_bytes = 0;
+};
+
+namespace synthetic_corpus_detail {
+	inline bool every(const std::size_t i, const std::size_t n) {
+		return n != 0 && i % n == 0;
+	}
+
+	inline std::string make_field_type(const std::size_t f, const bool is_template) {
+		if (is_template && f % 4 == 1) {
+			return "T";
+		}
+
+		switch (f % 6) {
+			case 0: return "int";
+			case 1: return "unsigned";
+			case 2: return "double";
+			case 3: return "std::vector<int>";
+			case 4: return "std::pair<float, float>";
+			default: return "bool";
+		}
+	}
+
+	inline std::string make_field_initializer(const std::size_t f) {
+		return f % 3 == 0 ? " = {}" : "";
+	}
+}
+
+inline synthetic_corpus_stats write_synthetic_corpus(
+	const std::string& directory,
+	const synthetic_corpus_settings& settings
+) {
+	using namespace synthetic_corpus_detail;
+
+	synthetic_corpus_stats stats;
+
+	const auto per_directory = std::max<std::size_t>(settings.headers_per_directory, 1);
+
+	for (std::size_t h = 0; h < settings.num_headers; ++h) {
+		const auto subdirectory = fs::path(directory) / ("d" + std::to_string(h / per_directory));
+		fs::create_directories(subdirectory);
+
+		std::string contents = "#pragma once\n#include <utility>\n#include <vector>\n\nnamespace augs {\n\tstruct introspection_access;\n}\n\n";
+
+		for (std::size_t s = 0; s < settings.structs_per_header; ++s) {
+			const auto type_index = h * settings.structs_per_header + s;
+			const bool is_template = every(type_index + 1, settings.template_every);
+			const bool is_namespaced = every(type_index + 1, settings.namespace_every);
+
+			const auto name = typesafe_sprintf("type_%x_%x", h, s);
+			const auto qualified_name = is_namespaced ? "ns" + std::to_string(h % 8) + "::" + name : name;
+
+			std::string indent = "";
+
+			if (is_namespaced) {
+				contents += typesafe_sprintf("namespace ns%x {\n", h % 8);
+				indent = "\t";
+			}
+
+			if (is_template) {
+				contents += indent + "template <class T, class... Types>\n";
+			}
+
+			contents += indent + "struct " + name + " {\n";
+			contents += indent + "\tfriend struct augs::introspection_access;\n\n";
+
+			if (is_template) {
+				contents += indent + "\t// GEN INTROSPECTOR struct " + qualified_name + " class T class... Types\n";
+			}
+			else {
+				contents += indent + "\t// GEN INTROSPECTOR struct " + qualified_name + "\n";
+			}
+
+			for (std::size_t f = 0; f < settings.fields_per_struct; ++f) {
+				if (f > 0 && f % 5 == 0) {
+					contents += "#if SOME_FEATURE\n";
+					contents += indent + "\t" + make_field_type(f, is_template) + " field_" + std::to_string(f) + make_field_initializer(f) + ";\n";
+					contents += "#endif\n";
+				}
+				else {
+					contents += indent + "\t" + make_field_type(f, is_template) + " field_" + std::to_string(f) + make_field_initializer(f) + ";\n";
+				}
+
+				++stats.num_fields;
+			}
+
+			contents += indent + "\t// END GEN INTROSPECTOR\n\n";
+			contents += indent + "\tint get_sum() const {\n" + indent + "\t\treturn 0;\n" + indent + "\t}\n";
+			contents += indent + "};\n";
+
+			if (is_namespaced) {
+				contents += "}\n";
+			}
+
+			contents += "\n";
+			++stats.num_types;
+		}
+
+		for (std::size_t e = 0; e < settings.enums_per_header; ++e) {
+			const auto type_index = h * settings.enums_per_header + e;
+			const bool is_namespaced = every(type_index + 1, settings.namespace_every);
+
+			const auto name = typesafe_sprintf("enum_%x_%x", h, e);
+			const auto qualified_name = is_namespaced ? "ns" + std::to_string(h % 8) + "::" + name : name;
+
+			std::string indent = "";
+
+			if (is_namespaced) {
+				contents += typesafe_sprintf("namespace ns%x {\n", h % 8);
+				indent = "\t";
+			}
+
+			contents += indent + "enum class " + name + " {\n";
+			contents += indent + "\t// GEN INTROSPECTOR enum class " + qualified_name + "\n";
+
+			for (std::size_t v = 0; v < settings.enumerators_per_enum; ++v) {
+				contents += indent + "\tVALUE_" + std::to_string(v) + ",\n";
+				++stats.num_fields;
+			}
+
+			contents += indent + "\tCOUNT\n";
+			contents += indent + "\t// END GEN INTROSPECTOR\n";
+			contents += indent + "};\n";
+
+			if (is_namespaced) {
+				contents += "}\n";
+			}
+
+			contents += "\n";
+			++stats.num_types;
+			++stats.num_fields;
+		}
+
+		const auto path = subdirectory / ("h" + std::to_string(h) + ".h");
+
+		std::ofstream out(path, std::ios::out | std::ios::binary);
+		out << contents;
+
+		stats.num_bytes += contents.size();
+		++stats.num_headers;
+	}
+
+	return stats;
+}
@@ -0,0 +1,715 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "spellbook.h"
+#include "introspected_type.h"
+#include "generator_configuration.h"
+#include "perfect_hash.h"
+#include "structural_hash.h"
+
+/*
+	Formatting of a single introspected type.
+
+	Every emitter appends to any Out that has append(const char*, std::size_t),
+	so that the same code can build strings in memory or stream straight into the generated files.
+*/
+
+struct type_naming {
+	/* With template arguments, e.g. temp_many<T, Types...> */
+	std::string type_name;
+
+	/* Ready to be pasted after another template parameter, e.g. ", class T, class... Types" */
+	std::string template_template_arguments;
+
+	std::string namespace_of_type;
+	std::string type_without_namespace;
+};
+
+inline type_naming make_type_naming(const introspected_type& t) {
+	const auto& type_name_without_templates = t.type_name_without_templates;
+	const auto& template_arguments = t.template_arguments;
+
+	type_naming out;
+
+	auto& type_name = out.type_name;
+	auto& template_template_arguments = out.template_template_arguments;
+
+	type_name = type_name_without_templates;
+
+	std::string argument_template_arguments;
+
+	if (template_arguments.size() > 0) {
+		argument_template_arguments = "<";
+		template_template_arguments = ", ";
+
+		for (size_t a = 0; a < template_arguments.size(); ++a) {
+			argument_template_arguments += template_arguments[a].second;
+
+			if (template_arguments[a].first.find("...") != std::string::npos) {
+				argument_template_arguments += "...";
+			}
+
+			template_template_arguments += template_arguments[a].first + " " + template_arguments[a].second;
+
+			if (a != template_arguments.size() - 1) {
+				argument_template_arguments += ", ";
+				template_template_arguments += ", ";
+			}
+		}
+
+		argument_template_arguments += ">";
+
+		type_name += argument_template_arguments;
+	}
+
+	out.type_without_namespace = type_name_without_templates;
+	out.namespace_of_type = "<unnamed>";
+
+	const auto found_colons = type_name_without_templates.find("::");
+
+	if (found_colons != std::string::npos) {
+		const auto& name = type_name_without_templates;
+
+		out.namespace_of_type = name.substr(0, found_colons);
+		out.type_without_namespace = name.substr(found_colons + 2);
+	}
+
+	return out;
+}
+
+class forward_declarations {
+	std::map<std::string, std::string> namespaces;
+
+public:
+	void add(const introspected_type& t) {
+		const auto naming = make_type_naming(t);
+
+		std::vector<std::string> forward_declaration_lines;
+
+		if (t.template_arguments.size()) {
+			forward_declaration_lines.push_back(
+				typesafe_sprintf("template %x\n", "<" + naming.template_template_arguments.substr(2) + ">")
+			);
+		}
+
+		forward_declaration_lines.push_back(
+			typesafe_sprintf(
+				"%x %x;\n",
+				t.struct_or_class_or_enum,
+				naming.type_without_namespace
+			)
+		);
+
+		const bool should_add_tabulation = naming.namespace_of_type != "<unnamed>";
+
+		if (should_add_tabulation) {
+			for (auto& l : forward_declaration_lines) {
+				l = "	" + l;
+			}
+		}
+
+		for (const auto& l : forward_declaration_lines) {
+			namespaces[naming.namespace_of_type] += l;
+		}
+	}
+
+	/*
+		Merging declarations in the order of their types
+		gives the same result as adding all the types to a single object.
+	*/
+
+	void merge(const forward_declarations& b) {
+		for (const auto& n : b.namespaces) {
+			namespaces[n.first] += n.second;
+		}
+	}
+
+	std::string make() const {
+		std::string all;
+
+		for (const auto& n : namespaces) {
+			if (n.first == "<unnamed>") {
+				all += typesafe_sprintf("%x\n", n.second);
+			}
+			else {
+				all += typesafe_sprintf("namespace %x {\n%x}\n\n", n.first, n.second);
+			}
+		}
+
+		return all;
+	}
+};
+
+/*
+	Fills introspector-metadata-format with the template arguments, the type,
+	the number of fields, the quoted field names
+	and the fields formatted with introspector-metadata-field-format, separated by commas, e.g.
+
+		2
+		"x", "y"
+		&Self::x, &Self::y
+
+	Fields under preprocessor conditions can only be counted by the compiler,
+	so then every name and formatted field gets its own line ending with a comma,
+	starting on the line after the slot,
+	and the count becomes a sum of ones between the same conditions.
+	Both forms are valid inside braces.
+*/
+
+template <class Out>
+void emit_field_metadata(
+	const generator_configuration& cfg,
+	const introspected_type& t,
+	const type_naming& naming,
+	Out& out
+) {
+	const auto is_condition = [](const block_line& l) {
+		return l.type == block_line_type::INTACT && l.text.find_first_not_of(" \t\r") != std::string::npos;
+	};
+
+	const bool has_conditions = std::any_of(t.lines.begin(), t.lines.end(), is_condition);
+
+	std::string count;
+	std::string names;
+	std::string fields;
+	std::size_t num_fields = 0;
+
+	if (has_conditions) {
+		/* So that a condition never shares a line with whatever precedes the slot */
+		count = "0\n";
+		names = "\n";
+		fields = "\n";
+	}
+
+	for (const auto& l : t.lines) {
+		if (l.type == block_line_type::INTACT) {
+			if (is_condition(l)) {
+				count.append(l.text) += '\n';
+				names.append(l.text) += '\n';
+				fields.append(l.text) += '\n';
+			}
+
+			continue;
+		}
+
+		if (!has_conditions && num_fields > 0) {
+			names += ", ";
+			fields += ", ";
+		}
+
+		names.append("\"").append(l.text) += '"';
+
+		cfg.introspector_metadata_field_format.append_to(
+			fields,
+			l.text,
+			l.field_type
+		);
+
+		if (has_conditions) {
+			count += "+ 1\n";
+			names += ",\n";
+			fields += ",\n";
+		}
+
+		++num_fields;
+	}
+
+	if (!has_conditions) {
+		count = std::to_string(num_fields);
+	}
+
+	cfg.introspector_metadata_format.append_to(
+		out,
+		naming.template_template_arguments,
+		"::" + naming.type_name,
+		count,
+		names,
+		fields
+	);
+}
+
+/*
+	Fills serializer-format with the template arguments, the dummy pointer to the type
+	and the fields formatted with serializer-field-format, all twice:
+	once for the function that writes the type and once for the one that reads it.
+
+	The fields come in declaration order, preprocessor conditions included,
+	so that the field format can coalesce the adjacent trivially copyable ones into single copies.
+*/
+
+template <class Out>
+void emit_serializer(
+	const generator_configuration& cfg,
+	const introspected_type& t,
+	const type_naming& naming,
+	Out& out
+) {
+	std::string generated_fields;
+
+	for (const auto& l : t.lines) {
+		if (l.type == block_line_type::INTACT) {
+			generated_fields.append(l.text) += '\n';
+			continue;
+		}
+
+		cfg.serializer_field_format.append_to(
+			generated_fields,
+			l.text,
+			l.field_type
+		);
+	}
+
+	const auto dummy_pointer = "const ::" + naming.type_name + "* const";
+
+	cfg.serializer_format.append_to(
+		out,
+		naming.template_template_arguments,
+		dummy_pointer,
+		generated_fields,
+		naming.template_template_arguments,
+		dummy_pointer,
+		generated_fields
+	);
+}
+
+/*
+	Fills comparison-format with what four functions need, in order:
+
+	equality: the template arguments, the dummy pointer to the type and the fields,
+	hash: the template arguments, the dummy pointer to the type and the fields,
+	delta encoding: the template arguments, the dummy pointer to the type, the number of fields and the fields twice,
+	delta decoding: the template arguments, the dummy pointer to the type, the number of fields and the fields.
+
+	comparison-field-format gets the field's name and its index in declaration order,
+	which is the field's bit in the mask of changed fields.
+	Fields under preprocessor conditions are counted and indexed too,
+	so that the bits never depend on the conditions; the mask only gets a few bits that are never set.
+*/
+
+template <class Out>
+void emit_comparison(
+	const generator_configuration& cfg,
+	const introspected_type& t,
+	const type_naming& naming,
+	Out& out
+) {
+	std::string generated_fields;
+	std::size_t num_fields = 0;
+
+	for (const auto& l : t.lines) {
+		if (l.type == block_line_type::INTACT) {
+			generated_fields.append(l.text) += '\n';
+			continue;
+		}
+
+		cfg.comparison_field_format.append_to(
+			generated_fields,
+			l.text,
+			num_fields++
+		);
+	}
+
+	const auto dummy_pointer = "const ::" + naming.type_name + "* const";
+	const auto& template_arguments = naming.template_template_arguments;
+
+	cfg.comparison_format.append_to(
+		out,
+		template_arguments, dummy_pointer, generated_fields,
+		template_arguments, dummy_pointer, generated_fields,
+		template_arguments, dummy_pointer, num_fields, generated_fields, generated_fields,
+		template_arguments, dummy_pointer, num_fields, generated_fields
+	);
+}
+
+/*
+	Fills soa-format with the template arguments, the dummy pointer to the type,
+	and then the fields formatted with soa-field-format in every slot that remains,
+	since a structure of arrays goes over its fields in nearly every member function:
+	to declare the arrays, to push_back, erase or resize them all, to make a reference to an element and so on.
+
+	soa-field-format gets the field's name and its index in declaration order.
+	Preprocessor lines are kept between the fields.
+*/
+
+template <class Out>
+void emit_soa(
+	const generator_configuration& cfg,
+	const introspected_type& t,
+	const type_naming& naming,
+	Out& out
+) {
+	std::string generated_fields;
+	std::size_t num_fields = 0;
+
+	for (const auto& l : t.lines) {
+		if (l.type == block_line_type::INTACT) {
+			generated_fields.append(l.text) += '\n';
+			continue;
+		}
+
+		cfg.soa_field_format.append_to(
+			generated_fields,
+			l.text,
+			num_fields++
+		);
+	}
+
+	cfg.soa_format.append_repeating_last_to(
+		out,
+		naming.template_template_arguments,
+		"const ::" + naming.type_name + "* const",
+		generated_fields
+	);
+}
+
+/*
+	Fills structural-hash-format with the template arguments, the dummy pointer to the type,
+	and the fields formatted with structural-hash-field-format,
+	which gets the field's name, its ID and its hash, see structural_hash.h.
+	Preprocessor lines are kept between the fields, so the hash folded from them depends on the conditions.
+*/
+
+template <class Out>
+void emit_structural_hash(
+	const generator_configuration& cfg,
+	const introspected_type& t,
+	const type_naming& naming,
+	const structural_hashes& hashes,
+	Out& out
+) {
+	const auto& field_hashes = hashes.field_hashes.at(&t);
+
+	std::string generated_fields;
+	std::size_t num_fields = 0;
+
+	for (const auto& l : t.lines) {
+		if (l.type == block_line_type::INTACT) {
+			generated_fields.append(l.text) += '\n';
+			continue;
+		}
+
+		cfg.structural_hash_field_format.append_to(
+			generated_fields,
+			l.text,
+			make_field_id(l.text),
+			field_hashes[num_fields++]
+		);
+	}
+
+	cfg.structural_hash_format.append_to(
+		out,
+		naming.template_template_arguments,
+		"const ::" + naming.type_name + "* const",
+		generated_fields
+	);
+}
+
+/*
+	Fields formatted with introspector-field-format, skipping those for which skip(l) is true.
+	Intact lines are always kept.
+*/
+
+template <class F>
+std::string make_generated_fields(
+	const generator_configuration& cfg,
+	const introspected_type& t,
+	F&& skip
+) {
+	std::string generated_fields;
+
+	for (const auto& l : t.lines) {
+		if (l.type == block_line_type::INTACT) {
+			generated_fields.append(l.text) += '\n';
+			continue;
+		}
+
+		if (skip(l)) {
+			continue;
+		}
+
+		cfg.introspector_field_format.append_to(
+			generated_fields,
+			l.text,
+			l.field_type
+		);
+	}
+
+	return generated_fields;
+}
+
+/*
+	A tag filter is either a tag, e.g. "net", which keeps only the fields with // @net,
+	or a tag preceded by an exclamation mark, e.g. "!nosave", which keeps all the fields but those with // @nosave.
+
+	Fills tagged-introspector-body-format with the template arguments, the name of the filter,
+	e.g. "net" or "not_nosave", the dummy pointer to the type and the fields that pass the filter.
+	Since the fields are filtered when generating, the filtered introspectors never even touch the others.
+*/
+
+template <class Out>
+void emit_tagged_introspector(
+	const generator_configuration& cfg,
+	const introspected_type& t,
+	const type_naming& naming,
+	const std::string& filter,
+	Out& out
+) {
+	const bool excludes = !filter.empty() && filter[0] == '!';
+	const auto tag = excludes ? filter.substr(1) : filter;
+
+	const auto found = std::find(t.tag_names.begin(), t.tag_names.end(), tag);
+
+	const std::uint32_t tag_bit =
+		found == t.tag_names.end()
+		? 0
+		: std::uint32_t(1) << (found - t.tag_names.begin())
+	;
+
+	const auto generated_fields = make_generated_fields(cfg, t, [&](const block_line& l) {
+		const bool has_tag = (l.tags & tag_bit) != 0;
+		return excludes ? has_tag : !has_tag;
+	});
+
+	cfg.tagged_introspector_body_format.append_to(
+		out,
+		naming.template_template_arguments,
+		excludes ? "not_" + tag : tag,
+		"const ::" + naming.type_name + "* const",
+		generated_fields
+	);
+}
+
+template <class Out>
+void emit_introspector(
+	const generator_configuration& cfg,
+	const introspected_type& t,
+	Out& out,
+	const structural_hashes* const hashes = nullptr
+) {
+	const auto naming = make_type_naming(t);
+
+	const auto generated_fields = make_generated_fields(cfg, t, [](const block_line&) {
+		return false;
+	});
+
+	cfg.introspector_body_format.append_to(
+		out,
+		naming.template_template_arguments,
+		"const ::" + naming.type_name + "* const",
+		//type_name,
+		generated_fields
+	);
+
+	for (const auto& filter : cfg.tagged_introspectors) {
+		emit_tagged_introspector(cfg, t, naming, filter, out);
+	}
+
+	if (!cfg.introspector_metadata_format.empty()) {
+		emit_field_metadata(cfg, t, naming, out);
+	}
+
+	if (!cfg.serializer_format.empty()) {
+		emit_serializer(cfg, t, naming, out);
+	}
+
+	if (!cfg.comparison_format.empty()) {
+		emit_comparison(cfg, t, naming, out);
+	}
+
+	if (!cfg.soa_format.empty()) {
+		emit_soa(cfg, t, naming, out);
+	}
+
+	if (hashes != nullptr) {
+		emit_structural_hash(cfg, t, naming, *hashes, out);
+	}
+}
+
+template <class Out>
+void emit_specialized_list(
+	const generator_configuration& cfg,
+	const introspected_type& t,
+	Out& out
+) {
+	const auto naming = make_type_naming(t);
+
+	std::string generated_fields_list;
+	int num_generated_fields = 0;
+
+	for (const auto& l : t.lines) {
+		if (l.type == block_line_type::INTACT) {
+			generated_fields_list.append(l.text) += '\n';
+			continue;
+		}
+
+		if (num_generated_fields > 0) {
+			generated_fields_list += ", ";
+		}
+
+		generated_fields_list.append("TYPEOF(").append(l.text) += ")\n";
+		++num_generated_fields;
+	}
+
+	cfg.specialized_list_format.append_to(
+		out,
+		naming.template_template_arguments,
+		"::" + naming.type_name,
+		generated_fields_list
+	);
+}
+
+/*
+	Fills enum-lookup-format with the enum, the number of enumerators,
+	the quoted enumerator names indexed by value, and the perfect hash over the names:
+	the number of seeds, the seeds, the number of slots and the slots, see perfect_hash.h.
+
+	Enumerators cannot have initializers, so their values are always 0, 1, 2...
+	and the names can be looked up by value directly.
+	Under preprocessor conditions the values are not known until compilation,
+	so such enums get no lookup at all.
+*/
+
+template <class Out>
+void emit_enum_lookup(
+	const generator_configuration& cfg,
+	const introspected_type& t,
+	const type_naming& naming,
+	Out& out
+) {
+	std::vector<std::string_view> enumerators;
+
+	for (const auto& l : t.lines) {
+		if (l.type == block_line_type::INTACT) {
+			if (l.text.find_first_not_of(" \t\r") != std::string::npos) {
+				return;
+			}
+
+			continue;
+		}
+
+		enumerators.push_back(l.text);
+	}
+
+	if (const auto duplicate = find_duplicate_key(enumerators); duplicate != enumerators.size()) {
+		throw header_parse_error(typesafe_sprintf(
+			"Enumerator %x appears more than once in %x.\n",
+			enumerators[duplicate],
+			naming.type_name
+		));
+	}
+
+	perfect_hash hash;
+
+	try {
+		hash = make_perfect_hash(enumerators);
+	}
+	catch (const std::runtime_error& err) {
+		throw header_parse_error(typesafe_sprintf("Cannot make the lookup table of %x. %x\n", naming.type_name, err.what()));
+	}
+
+	std::string names;
+	std::string seeds;
+	std::string slots;
+
+	for (const auto& e : enumerators) {
+		if (!names.empty()) {
+			names += ", ";
+		}
+
+		names.append("\"").append(e) += '"';
+	}
+
+	for (const auto seed : hash.seeds) {
+		if (!seeds.empty()) {
+			seeds += ", ";
+		}
+
+		seeds += std::to_string(seed);
+	}
+
+	for (const auto slot : hash.slots) {
+		if (!slots.empty()) {
+			slots += ", ";
+		}
+
+		slots += std::to_string(slot);
+	}
+
+	cfg.enum_lookup_format.append_to(
+		out,
+		"::" + naming.type_name,
+		enumerators.size(),
+		names,
+		hash.seeds.size(),
+		seeds,
+		hash.slots.size(),
+		slots
+	);
+}
+
+template <class Out>
+void emit_enum(
+	const generator_configuration& cfg,
+	const introspected_type& t,
+	Out& out
+) {
+	const auto naming = make_type_naming(t);
+
+	std::string generated_fields;
+	std::string generated_enum_args;
+	int num_generated_fields = 0;
+
+	for (const auto& l : t.lines) {
+		if (l.type == block_line_type::INTACT) {
+			generated_fields.append(l.text) += '\n';
+			generated_enum_args.append(l.text) += '\n';
+			continue;
+		}
+
+		cfg.enum_field_format.append_to(
+			generated_fields,
+			l.text
+		);
+
+		++num_generated_fields;
+
+		if (!cfg.enum_arg_format.empty()) {
+			cfg.enum_arg_format.append_to(
+				generated_enum_args,
+				l.text
+			);
+		}
+	}
+
+	cfg.enum_introspector_body_format.append_to(
+		out,
+		"::" + naming.type_name,
+		num_generated_fields,
+		generated_fields,
+		num_generated_fields
+	);
+
+	if (generated_enum_args.size() > 0) {
+		const auto cm = generated_enum_args.rfind(',');
+
+		if (cm != std::string::npos) {
+			generated_enum_args.erase(generated_enum_args.begin() + cm); // peel off the trailing comma
+		}
+	}
+
+	if (!cfg.enum_to_args_body_format.empty()) {
+		cfg.enum_to_args_body_format.append_to(
+			out,
+			"::" + naming.type_name,
+			generated_enum_args
+		);
+	}
+
+	if (!cfg.enum_lookup_format.empty()) {
+		emit_enum_lookup(cfg, t, naming, out);
+	}
+}
@@ -0,0 +1,186 @@
+#pragma once
+#include <cctype>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "introspected_type.h"
+#include "scan_cache.h"
+
+/*
+	Keeps only the types that can be reached from root-types through the types of fields.
+
+	The field types are known only as text, e.g. "std::vector<entity_id>" or "augs::enum_array<float, effect_type>",
+	so every identifier in them is taken as a possible reference to any introspected type of that name, in whatever namespace.
+	This keeps too much rather than too little when names repeat across namespaces.
+	What it cannot see is a type referred to only through an alias or a base class;
+	such types should be listed in root-types themselves.
+
+	The scan cache is never pruned, only the model the outputs are generated from,
+	so changing root-types needs no headers to be scanned again.
+*/
+
+inline std::string_view get_unqualified_name(std::string_view name) {
+	const auto last_colon = name.rfind(':');
+
+	if (last_colon != std::string_view::npos) {
+		name.remove_prefix(last_colon + 1);
+	}
+
+	return name;
+}
+
+/*
+	Introspected types by their unqualified names,
+	so that the identifiers in the type of a field can be taken as references to them.
+*/
+
+struct type_name_index {
+	std::unordered_map<std::string_view, std::vector<std::size_t>> by_name;
+
+	explicit type_name_index(const std::vector<const introspected_type*>& types) {
+		for (std::size_t i = 0; i < types.size(); ++i) {
+			by_name[get_unqualified_name(types[i]->type_name_without_templates)].push_back(i);
+		}
+	}
+
+	/* Calls f with the index of every type that an identifier in field_type may name, in the order of the identifiers */
+	template <class F>
+	void for_each_referenced(const std::string_view field_type, F&& f) const {
+		const auto is_identifier_char = [](const char c) {
+			return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+		};
+
+		for (std::size_t begin = 0; begin < field_type.size(); ) {
+			if (!is_identifier_char(field_type[begin])) {
+				++begin;
+				continue;
+			}
+
+			auto end = begin;
+
+			while (end < field_type.size() && is_identifier_char(field_type[end])) {
+				++end;
+			}
+
+			const auto found = by_name.find(field_type.substr(begin, end - begin));
+
+			if (found != by_name.end()) {
+				for (const auto i : found->second) {
+					f(i);
+				}
+			}
+
+			begin = end;
+		}
+	}
+};
+
+/* All types of the model, in the order of header_files */
+
+inline std::vector<const introspected_type*> gather_introspected_types(
+	const std::vector<std::string>& header_files,
+	const scan_cache& model
+) {
+	std::vector<const introspected_type*> types;
+
+	for (const auto& path : header_files) {
+		const auto found = model.entries.find(path);
+
+		if (found != model.entries.end()) {
+			for (const auto& t : found->second.types) {
+				types.push_back(&t);
+			}
+		}
+	}
+
+	return types;
+}
+
+struct pruned_model {
+	scan_cache model;
+
+	/* Qualified names, in the order in which the types were found */
+	std::vector<std::string> pruned_types;
+
+	/* Roots that name no introspected type, most likely typos */
+	std::vector<std::string> unknown_root_types;
+};
+
+inline pruned_model prune_unreachable_types(
+	const std::vector<std::string>& root_types,
+	const std::vector<std::string>& header_files,
+	const scan_cache& model
+) {
+	const auto types = gather_introspected_types(header_files, model);
+	const auto names = type_name_index(types);
+
+	pruned_model out;
+
+	std::vector<bool> reached(types.size(), false);
+	std::vector<std::size_t> to_visit;
+
+	auto reach = [&](const std::size_t i) {
+		if (!reached[i]) {
+			reached[i] = true;
+			to_visit.push_back(i);
+		}
+	};
+
+	for (const auto& root : root_types) {
+		const bool qualified = root.find(':') != std::string::npos;
+		const auto found = names.by_name.find(get_unqualified_name(root));
+
+		bool known = false;
+
+		if (found != names.by_name.end()) {
+			for (const auto i : found->second) {
+				/* An unqualified root names the type in every namespace */
+				if (!qualified || types[i]->type_name_without_templates == root || "::" + types[i]->type_name_without_templates == root) {
+					reach(i);
+					known = true;
+				}
+			}
+		}
+
+		if (!known) {
+			out.unknown_root_types.push_back(root);
+		}
+	}
+
+	while (!to_visit.empty()) {
+		const auto i = to_visit.back();
+		to_visit.pop_back();
+
+		for (const auto& l : types[i]->lines) {
+			names.for_each_referenced(l.field_type, reach);
+		}
+	}
+
+	out.model.beginning_line = model.beginning_line;
+	out.model.ending_line = model.ending_line;
+
+	std::size_t i = 0;
+
+	for (const auto& path : header_files) {
+		const auto found = model.entries.find(path);
+
+		if (found == model.entries.end()) {
+			continue;
+		}
+
+		auto& entry = out.model.entries[path];
+
+		for (const auto& t : found->second.types) {
+			if (reached[i++]) {
+				entry.types.push_back(t);
+			}
+			else {
+				out.pruned_types.push_back(t.type_name_without_templates);
+			}
+		}
+	}
+
+	return out;
+}
@@ -0,0 +1,366 @@
+#pragma once
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "generator.h"
+
+/*
+	--watch keeps the generator resident and regenerates whenever a scanned header changes.
+
+	The parsed model of every header stays in memory between regenerations,
+	so only the headers reported by inotify are read and parsed again.
+	Outputs are still streamed through streaming_file_writer,
+	so only the generated files whose contents actually changed are touched.
+
+	Changes to the configuration file are picked up as well.
+	The scan cache is saved after every regeneration,
+	so a regular run right after the daemon exits is a no-op.
+*/
+
+#if defined(__linux__)
+namespace watch_mode_detail {
+	inline std::string normalize(const fs::path& p) {
+		return fs::absolute(p).lexically_normal().string();
+	}
+
+	class inotify_watcher {
+		int fd = -1;
+		std::unordered_map<int, fs::path> directories;
+
+	public:
+		inotify_watcher() : fd(::inotify_init1(IN_CLOEXEC)) {}
+
+		~inotify_watcher() {
+			if (fd != -1) {
+				::close(fd);
+			}
+		}
+
+		inotify_watcher(const inotify_watcher&) = delete;
+		inotify_watcher& operator=(const inotify_watcher&) = delete;
+
+		bool valid() const {
+			return fd != -1;
+		}
+
+		void watch_directory(const fs::path& dir) {
+			const auto wd = ::inotify_add_watch(
+				fd,
+				dir.string().c_str(),
+				IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF
+			);
+
+			if (wd != -1) {
+				directories[wd] = dir;
+			}
+		}
+
+		void watch_tree(const fs::path& root) {
+			std::error_code err;
+
+			if (!fs::is_directory(root, err)) {
+				return;
+			}
+
+			watch_directory(root);
+
+			for (fs::recursive_directory_iterator i(root, err), end; !err && i != end; i.increment(err)) {
+				if (i->is_directory(err)) {
+					watch_directory(i->path());
+				}
+			}
+		}
+
+		struct event {
+			fs::path path;
+			bool is_directory = false;
+			bool structural = false;
+		};
+
+		/*
+			Blocks until something happens, then keeps collecting events
+			until there is a short moment of silence, so that a single save
+			or a branch checkout results in a single regeneration.
+
+			Returns false if the whole tree should be walked again.
+		*/
+
+		bool wait(std::vector<event>& events) {
+			constexpr int debounce_ms = 30;
+
+			alignas(inotify_event) char buffer[64 * 1024];
+
+			bool overflown = false;
+			pollfd p = { fd, POLLIN, 0 };
+
+			for (int timeout = -1; ::poll(&p, 1, timeout) > 0; timeout = debounce_ms) {
+				const auto len = ::read(fd, buffer, sizeof(buffer));
+
+				if (len <= 0) {
+					break;
+				}
+
+				for (auto ptr = buffer; ptr < buffer + len; ) {
+					const auto& e = *reinterpret_cast<const inotify_event*>(ptr);
+					ptr += sizeof(inotify_event) + e.len;
+
+					if (e.mask & IN_Q_OVERFLOW) {
+						overflown = true;
+						continue;
+					}
+
+					if (e.mask & IN_IGNORED) {
+						directories.erase(e.wd);
+						continue;
+					}
+
+					const auto found = directories.find(e.wd);
+
+					if (found == directories.end()) {
+						continue;
+					}
+
+					event new_event;
+					new_event.path = e.len > 0 ? found->second / e.name : found->second;
+					new_event.is_directory = (e.mask & IN_ISDIR) != 0;
+					new_event.structural = (e.mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF)) != 0;
+
+					if (new_event.is_directory && (e.mask & (IN_CREATE | IN_MOVED_TO))) {
+						watch_tree(new_event.path);
+					}
+
+					events.emplace_back(std::move(new_event));
+				}
+			}
+
+			return !overflown;
+		}
+	};
+}
+
+inline int run_watch_mode(
+	const std::string& configuration_file_input_path,
+	generator_configuration cfg,
+	const std::size_t num_jobs
+) {
+	using namespace watch_mode_detail;
+	using namespace std::chrono;
+
+	inotify_watcher watcher;
+
+	if (!watcher.valid()) {
+		std::cout << "Failure\nCould not initialize inotify." << std::endl;
+		return 1;
+	}
+
+	const auto configuration_path = normalize(configuration_file_input_path);
+
+	std::vector<std::string> header_files;
+	std::unordered_map<std::string, std::string> header_by_normalized_path;
+	std::unordered_set<std::string> ignored_paths;
+
+	/* Changed headers that could not be applied yet because of a parse error */
+	std::unordered_set<std::string> pending_headers;
+
+	auto model = load_scan_cache(get_scan_cache_path(cfg.generated_file_path), cfg.beginning_line, cfg.ending_line);
+
+	auto watch_everything = [&]() {
+		watcher.watch_directory(fs::path(configuration_path).parent_path());
+
+		for (const auto& d : cfg.header_directories) {
+			watcher.watch_tree(d);
+		}
+
+		for (const auto& f : cfg.header_files) {
+			watcher.watch_directory(fs::path(normalize(f)).parent_path());
+		}
+
+		ignored_paths = {
+			normalize(cfg.generated_file_path),
+			normalize(cfg.generated_specializations_path),
+			normalize(cfg.generated_enums_path),
+			normalize(get_scan_cache_path(cfg.generated_file_path))
+		};
+	};
+
+	auto find_headers = [&]() {
+		header_files = find_header_files(cfg, num_jobs);
+		header_by_normalized_path.clear();
+
+		for (const auto& h : header_files) {
+			header_by_normalized_path[normalize(h)] = h;
+		}
+	};
+
+	/*
+		A header may vanish between the walk and the read, or an output may fail to be written,
+		neither of which should end the watch. The next change tries again.
+	*/
+
+	auto report_failure = [](const std::exception& err) {
+		std::cout << "Failure\n" << err.what() << "\nWatching for further changes." << std::endl;
+	};
+
+	/*
+		Rescans the given headers and those missing from the model,
+		then regenerates the outputs from the whole model.
+	*/
+
+	auto regenerate = [&](const std::unordered_set<std::string>& changed_headers) {
+		const auto start = high_resolution_clock::now();
+
+		pending_headers.insert(changed_headers.begin(), changed_headers.end());
+
+		std::vector<std::string> to_scan;
+
+		for (const auto& h : header_files) {
+			if (pending_headers.count(h) || model.entries.count(h) == 0) {
+				to_scan.push_back(h);
+			}
+		}
+
+		try {
+			/* Headers may be truncated by an editor while we read them, which would be SIGBUS with a mapping */
+			auto scanned = scan_headers(to_scan, model, num_jobs, nullptr, false);
+
+			for (std::size_t i = 0; i < to_scan.size(); ++i) {
+				model.entries[to_scan[i]] = std::move(scanned[i]);
+			}
+		}
+		catch (const header_parse_error& err) {
+			report_parse_error(cfg, err);
+			return;
+		}
+		catch (const std::exception& err) {
+			report_failure(err);
+			return;
+		}
+
+		pending_headers.clear();
+
+		const auto current_headers = std::unordered_set<std::string>(header_files.begin(), header_files.end());
+
+		for (auto it = model.entries.begin(); it != model.entries.end(); ) {
+			if (current_headers.count(it->first) == 0) {
+				it = model.entries.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+
+		try {
+			write_outputs(cfg, header_files, model);
+			save_scan_cache(get_scan_cache_path(cfg.generated_file_path), model);
+		}
+		catch (const header_parse_error& err) {
+			report_parse_error(cfg, err);
+			return;
+		}
+		catch (const std::exception& err) {
+			report_failure(err);
+			return;
+		}
+
+		std::cout << "Regenerated after rescanning " << to_scan.size() << " header(s) in "
+			<< duration_cast<duration<double, milliseconds::period>>(high_resolution_clock::now() - start).count() << " ms" << std::endl;
+	};
+
+	watch_everything();
+	find_headers();
+	regenerate({ header_files.begin(), header_files.end() });
+
+	std::cout << "Watching " << header_files.size() << " headers for changes." << std::endl;
+
+	while (true) {
+		std::vector<inotify_watcher::event> events;
+
+		bool walk_again = !watcher.wait(events);
+		bool configuration_changed = false;
+
+		std::unordered_set<std::string> changed_headers;
+
+		for (const auto& e : events) {
+			const auto path = normalize(e.path);
+
+			if (ignored_paths.count(path)) {
+				continue;
+			}
+
+			if (path == configuration_path) {
+				configuration_changed = true;
+				continue;
+			}
+
+			if (e.is_directory) {
+				walk_again = walk_again || e.structural;
+				continue;
+			}
+
+			const auto found = header_by_normalized_path.find(path);
+
+			if (found != header_by_normalized_path.end()) {
+				changed_headers.insert(found->second);
+				walk_again = walk_again || e.structural;
+			}
+			else if (e.structural && cfg.header_filter.has_header_extension(e.path.filename().string())) {
+				walk_again = true;
+			}
+		}
+
+		if (configuration_changed) {
+			try {
+				cfg = read_generator_configuration(configuration_file_input_path);
+				std::cout << "Configuration reloaded." << std::endl;
+			}
+			catch (...) {
+				std::cout << "Failure\nError while reading configuration values. Keeping the previous configuration." << std::endl;
+				continue;
+			}
+
+			if (cfg.beginning_line != model.beginning_line || cfg.ending_line != model.ending_line) {
+				model = scan_cache();
+				model.beginning_line = cfg.beginning_line;
+				model.ending_line = cfg.ending_line;
+			}
+
+			watch_everything();
+			walk_again = true;
+		}
+
+		if (walk_again) {
+			try {
+				find_headers();
+			}
+			catch (const std::exception& err) {
+				/* Keeps the headers found by the previous walk */
+				report_failure(err);
+			}
+		}
+
+		if (walk_again || configuration_changed || !changed_headers.empty()) {
+			regenerate(changed_headers);
+		}
+	}
+}
+#else
+inline int run_watch_mode(
+	const std::string&,
+	generator_configuration,
+	const std::size_t
+) {
+	std::cout << "Failure\n--watch is only supported on Linux." << std::endl;
+	return 1;
+}
+#endif
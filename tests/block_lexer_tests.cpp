@@ -0,0 +1,166 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "block_lexer.h"
+
+/*
+	Feeds a block to the lexer line by line and compares the fields it found
+	with the expected ones, given as "name: type".
+*/
+
+static int num_failures = 0;
+
+static void expect_fields(
+	const std::vector<std::string>& lines,
+	const std::vector<std::string>& expected
+) {
+	block_lexer lexer(false);
+	std::vector<block_line> out;
+
+	bool ok = true;
+
+	for (const auto& l : lines) {
+		ok = ok && lexer.feed(l, out);
+	}
+
+	ok = ok && lexer.finish();
+
+	std::vector<std::string> found;
+
+	for (const auto& l : out) {
+		if (l.type == block_line_type::FIELD) {
+			found.push_back(l.text + ": " + l.field_type);
+		}
+	}
+
+	if (!ok || found != expected) {
+		++num_failures;
+
+		std::cout << "Failed on:\n";
+
+		for (const auto& l : lines) {
+			std::cout << "\t" << l << "\n";
+		}
+
+		std::cout << (ok ? "Found:\n" : "Rejected after finding:\n");
+
+		for (const auto& f : found) {
+			std::cout << "\t" << f << "\n";
+		}
+	}
+}
+
+/*
+	Same, but compares the tags of the fields, given as "name: tag tag".
+	A block that should be rejected expects an empty list.
+*/
+
+static void expect_tags(
+	const std::vector<std::string>& lines,
+	const std::vector<std::string>& expected
+) {
+	block_lexer lexer(false);
+	std::vector<block_line> out;
+
+	bool ok = true;
+
+	for (const auto& l : lines) {
+		ok = ok && lexer.feed(l, out);
+	}
+
+	ok = ok && lexer.finish();
+
+	std::vector<std::string> found;
+
+	if (ok) {
+		for (const auto& l : out) {
+			if (l.type == block_line_type::FIELD) {
+				std::string f = l.text + ":";
+
+				for (std::size_t t = 0; t < lexer.get_tag_names().size(); ++t) {
+					if (l.tags & (std::uint32_t(1) << t)) {
+						f += " " + lexer.get_tag_names()[t];
+					}
+				}
+
+				found.push_back(f);
+			}
+		}
+	}
+
+	if (found != expected) {
+		++num_failures;
+
+		std::cout << "Failed on:\n";
+
+		for (const auto& l : lines) {
+			std::cout << "\t" << l << "\n";
+		}
+
+		std::cout << (ok ? "Found:\n" : "Rejected.\n");
+
+		for (const auto& f : found) {
+			std::cout << "\t" << f << "\n";
+		}
+	}
+}
+
+int main() {
+	expect_fields({ "int a, b;" }, { "a: int", "b: int" });
+	expect_fields({ "int *a, b;" }, { "a: int *", "b: int" });
+	expect_fields({ "const char* s, c;" }, { "s: const char*", "c: const char" });
+	expect_fields({ "int* p, *q;" }, { "p: int*", "q: int*" });
+	expect_fields({ "std::map<int, float*>* m, n;" }, { "m: std::map<int, float*>*", "n: std::map<int, float*>" });
+
+	expect_fields({ "unsigned  int x;", "unsigned\tlong  y = 0;" }, { "x: unsigned  int", "y: unsigned\tlong" });
+	expect_fields({ "\tstd::map<", "\t\tint,  float", "\t> m;\r" }, { "m: std::map< int,  float >" });
+
+	expect_fields({ "decltype(a) b;" }, { "b: decltype(a)" });
+	expect_fields({ "alignas(8) int c = 0;" }, { "c: alignas(8) int" });
+	expect_fields({ "[[no_unique_address]] empty_t e;" }, { "e: [[no_unique_address]] empty_t" });
+	expect_fields({ "std::function<void() noexcept(true)> f;", "decltype(f) noexcept_free;" }, { "f: std::function<void() noexcept(true)>", "noexcept_free: decltype(f)" });
+	expect_fields({ "int get() noexcept(false);", "int x;" }, { "x: int" });
+
+	expect_fields({ "bool operator<(const a&) const;", "int x;" }, { "x: int" });
+	expect_fields({ "bool operator<=(const a&) const;", "int x;" }, { "x: int" });
+	expect_fields({ "a& operator<<(int);", "int x;" }, { "x: int" });
+	expect_fields({ "a& operator+=(const a&);", "bool operator!=(const a&) const;", "int x;" }, { "x: int" });
+	expect_fields({ "int& operator[](std::size_t);", "operator bool() const;", "int x;" }, { "x: int" });
+	expect_fields({ "bool operator<(const a& o) const { return x < o.x; }", "int x;" }, { "x: int" });
+	expect_fields({ "bool operator<(const a& o) const {", "\treturn x < o.x;", "}", "int x;" }, { "x: int" });
+	expect_fields({ "std::vector<int> get() const { return {}; }", "std::function<void(int)> f;" }, { "f: std::function<void(int)>" });
+
+	expect_tags({ "int a; // @net", "int b; //@net @nosave", "int c;" }, { "a: net", "b: net nosave", "c:" });
+	expect_tags({ "int a, // @net", "\tb;" }, { "a: net", "b: net" });
+	expect_tags({ "int a; // @brief the count", "int b; // @param x", "int c; // mail me@example.com" }, { "a:", "b:", "c:" });
+	expect_tags({ "int a; // @net, @nosave", "int b; // @net-ish", "int c; // @" }, { "a:", "b:", "c:" });
+
+	{
+		std::vector<std::string> too_many;
+
+		for (int t = 0; t <= 32; ++t) {
+			too_many.push_back("int f" + std::to_string(t) + "; // @t" + std::to_string(t));
+		}
+
+		expect_tags(too_many, {});
+
+		std::vector<std::string> doxygen;
+		std::vector<std::string> untagged;
+
+		for (int t = 0; t <= 32; ++t) {
+			doxygen.push_back("int f" + std::to_string(t) + "; // @see t" + std::to_string(t) + " and @ref r" + std::to_string(t));
+			untagged.push_back("f" + std::to_string(t) + ":");
+		}
+
+		expect_tags(doxygen, untagged);
+	}
+
+	if (num_failures > 0) {
+		std::cout << num_failures << " block_lexer test(s) failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "All block_lexer tests passed." << std::endl;
+	return 0;
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "directory_walk.h"
+
+/*
+	Checks the globs of header-include and header-exclude,
+	and that a walk finds the headers in the order of a single-threaded recursive walk, whatever the number of jobs.
+*/
+
+static int num_failures = 0;
+
+static void expect(const bool condition, const std::string& what) {
+	if (!condition) {
+		++num_failures;
+		std::cout << "Failed: " << what << "\n";
+	}
+}
+
+static void expect_glob(const std::string& pattern, const std::string& text, const bool expected) {
+	expect(glob_match(pattern, text) == expected, "\"" + pattern + "\" " + (expected ? "matching" : "not matching") + " \"" + text + "\"");
+}
+
+int main() {
+	expect_glob("", "", true);
+	expect_glob("", "a", false);
+	expect_glob("a.h", "a.h", true);
+	expect_glob("a.h", "b.h", false);
+	expect_glob("a.h", "a.hpp", false);
+
+	expect_glob("*", "", true);
+	expect_glob("*", "name.h", true);
+	expect_glob("*", "dir/name.h", false);
+	expect_glob("*_generated.h", "types_generated.h", true);
+	expect_glob("*_generated.h", "types_generated.hpp", false);
+	expect_glob("*.*.h", "a.b.h", true);
+	expect_glob("*.*.h", "a.h", false);
+
+	expect_glob("?.h", "a.h", true);
+	expect_glob("?.h", "ab.h", false);
+	expect_glob("?", "/", false);
+
+	expect_glob("**", "", true);
+	expect_glob("**", "a/b/c.h", true);
+	expect_glob("src/**/*.h", "src/a.h", true);
+	expect_glob("src/**/*.h", "src/a/b/c.h", true);
+	expect_glob("src/**/*.h", "other/a.h", false);
+	expect_glob("src/*.h", "src/a/b.h", false);
+	expect_glob("**/tests", "external/lib/tests", true);
+	expect_glob("**/tests", "tests", true);
+	expect_glob("external/tests", "external/tests", true);
+	expect_glob("external/tests", "external/tests2", false);
+
+	expect(matches_any_glob({ "build", "*.tmp.h" }, "build", "a/build"), "a pattern without a slash matching the name anywhere");
+	expect(!matches_any_glob({ "a/build" }, "build", "b/build"), "a pattern with a slash matching the relative path only");
+	expect(matches_any_glob({ "a/build" }, "build", "a/build"), "a pattern with a slash matching the relative path");
+	expect(!matches_any_glob({}, "a.h", "a.h"), "no patterns matching nothing");
+
+	{
+		header_file_filter filter;
+
+		expect(filter.is_header("a.h", "a.h"), "taking .h by default");
+		expect(!filter.is_header("a.hpp", "a.hpp"), "skipping .hpp by default");
+		expect(!filter.is_header("a.cpp", "a.cpp"), "skipping .cpp by default");
+
+		filter.extensions = { ".hpp", ".hxx" };
+
+		expect(!filter.is_header("a.h", "a.h"), "skipping .h once extensions are listed");
+		expect(filter.is_header("a.hxx", "a.hxx"), "taking a listed extension");
+
+		filter.extensions = {};
+		filter.include_patterns = { "game/**" };
+		filter.exclude_patterns = { "*_generated.h", "game/tests" };
+
+		expect(filter.is_header("a.h", "game/a.h"), "taking an included header");
+		expect(!filter.is_header("a.h", "editor/a.h"), "skipping a header that is not included");
+		expect(!filter.is_header("a_generated.h", "game/a_generated.h"), "skipping an excluded header");
+		expect(filter.is_excluded("tests", "game/tests"), "excluding a directory by its relative path");
+		expect(!filter.is_excluded("tests", "editor/tests"), "keeping a directory of the same name elsewhere");
+	}
+
+	{
+		const auto root = fs::temp_directory_path() / "introspector-generator-directory-walk-tests";
+
+		std::error_code err;
+		fs::remove_all(root, err);
+
+		for (const auto& d : { "b", "b/c", "a", "skipped" }) {
+			fs::create_directories(root / d);
+		}
+
+		for (const auto& f : { "z.h", "a.h", "b/m.h", "b/c/x.h", "b/y.h", "a/k.h", "a/k.cpp", "skipped/s.h" }) {
+			std::ofstream(root / f) << "";
+		}
+
+		header_file_filter filter;
+		filter.exclude_patterns = { "skipped" };
+
+		std::vector<std::string> found;
+		walk_header_directory(root.string(), filter, 1, found);
+
+		for (auto& h : found) {
+			h = fs::path(h).lexically_relative(root).generic_string();
+		}
+
+		std::sort(found.begin(), found.end());
+
+		expect(
+			found == std::vector<std::string> { "a.h", "a/k.h", "b/c/x.h", "b/m.h", "b/y.h", "z.h" },
+			"finding exactly the headers that are not excluded"
+		);
+
+		std::vector<std::string> first_walk;
+		walk_header_directory(root.string(), filter, 1, first_walk);
+
+		for (int attempt = 0; attempt < 20; ++attempt) {
+			std::vector<std::string> walk;
+			walk_header_directory(root.string(), filter, 8, walk);
+
+			expect(walk == first_walk, "walking on many threads in the order of a single thread");
+		}
+
+		fs::remove_all(root, err);
+	}
+
+	if (num_failures > 0) {
+		std::cout << num_failures << " directory_walk test(s) failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "All directory_walk tests passed." << std::endl;
+	return 0;
+}
@@ -0,0 +1,78 @@
+#include <iostream>
+#include <string>
+
+#include "format_template.h"
+
+/*
+	Checks that slots are filled with the arguments in order,
+	that missing arguments leave their slots as written, and that substituted arguments are never expanded again.
+*/
+
+static int num_failures = 0;
+
+static void expect_equal(const std::string& found, const std::string& expected, const std::string& what) {
+	if (found != expected) {
+		++num_failures;
+		std::cout << "Failed: " << what << "\n\tExpected: " << expected << "\n\tFound:    " << found << "\n";
+	}
+}
+
+int main() {
+	expect_equal(format_template()(), "", "expanding an empty format");
+	expect_equal(format_template("no slots")("ignored"), "no slots", "ignoring arguments without slots");
+
+	expect_equal(format_template("%x")("a"), "a", "filling a lone slot");
+	expect_equal(format_template("FIELD(%x);")("pos"), "FIELD(pos);", "filling a slot between literals");
+	expect_equal(format_template("%x%x")("a", "b"), "ab", "filling adjacent slots");
+	expect_equal(format_template("%x, %x, %x")("a", "b", "c"), "a, b, c", "filling slots in order");
+
+	expect_equal(format_template("%x and %x")("a"), "a and %x", "leaving a slot without an argument as written");
+	expect_equal(format_template("%x and %y")(), "%x and %y", "leaving every slot as written without arguments");
+	expect_equal(format_template("100%")("a"), "100a", "filling a slot at the very end");
+	expect_equal(format_template("100%")(), "100%", "leaving a slot at the very end as written");
+
+	expect_equal(format_template("<%x>")("%x"), "<%x>", "never expanding a substituted argument again");
+	expect_equal(format_template("%x %x")("%x", "b"), "%x b", "filling the next slot after an argument with a slot");
+
+	expect_equal(format_template("%x = %x;")("n", 42), "n = 42;", "filling a slot with an integer");
+	expect_equal(format_template("%x")(std::size_t(0)), "0", "filling a slot with zero");
+	expect_equal(format_template("%x")(-7), "-7", "filling a slot with a negative integer");
+	expect_equal(format_template("%x")(std::string("s")), "s", "filling a slot with a std::string");
+
+	expect_equal(
+		format_template("[%x]")([](std::string& out) { out += "generated"; }),
+		"[generated]",
+		"generating an argument straight into the output"
+	);
+
+	{
+		std::string out = "prefix ";
+		format_template("%x;").append_to(out, "a");
+
+		expect_equal(out, "prefix a;", "appending to what is already there");
+	}
+
+	{
+		std::string out;
+		format_template("%x: %x, %x, %x").append_repeating_last_to(out, "type", "fields");
+
+		expect_equal(out, "type: fields, fields, fields", "repeating the last argument for the remaining slots");
+	}
+
+	{
+		const auto t = format_template("a%xb%yc");
+
+		if (t.num_slots() != 2 || t.empty() || !format_template().empty() || format_template().num_slots() != 0) {
+			++num_failures;
+			std::cout << "Failed: counting slots\n";
+		}
+	}
+
+	if (num_failures > 0) {
+		std::cout << num_failures << " format_template test(s) failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "All format_template tests passed." << std::endl;
+	return 0;
+}
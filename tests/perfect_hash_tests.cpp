@@ -0,0 +1,118 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "type_emitters.h"
+
+/*
+	Checks that every key of a perfect hash is found at its own index,
+	and that keys which can never be told apart are rejected instead of searched for forever.
+*/
+
+static int num_failures = 0;
+
+static void expect(const bool condition, const std::string& what) {
+	if (!condition) {
+		++num_failures;
+		std::cout << "Failed: " << what << "\n";
+	}
+}
+
+static void expect_all_keys_found(const std::vector<std::string_view>& keys) {
+	const auto hash = make_perfect_hash(keys);
+
+	for (std::size_t k = 0; k < keys.size(); ++k) {
+		const auto seed = hash.seeds[perfect_hash_string(keys[k], 0) & (hash.seeds.size() - 1)];
+		const auto index = hash.slots[perfect_hash_string(keys[k], seed) & (hash.slots.size() - 1)];
+
+		expect(index == static_cast<int>(k), "finding " + std::string(keys[k]) + " among " + std::to_string(keys.size()) + " keys");
+	}
+}
+
+template <class E, class F>
+static void expect_throws(F&& f, const std::string& what) {
+	try {
+		f();
+	}
+	catch (const E&) {
+		return;
+	}
+	catch (...) {
+	}
+
+	expect(false, what);
+}
+
+int main() {
+	expect_all_keys_found({});
+	expect_all_keys_found({ "A" });
+	expect_all_keys_found({ "A", "B", "C" });
+	expect_all_keys_found({ "ab", "ba", "aab", "aba", "baa" });
+	expect_all_keys_found({ "", "a", "aa", "aaa" });
+	expect_all_keys_found({ "very_long_common_prefix_of_enumerators_1", "very_long_common_prefix_of_enumerators_2", "very_long_common_prefix_of_enumerators_10" });
+
+	{
+		std::vector<std::string> names;
+
+		for (int i = 0; i < 1000; ++i) {
+			names.push_back("enumerator_" + std::to_string(i));
+		}
+
+		expect_all_keys_found(std::vector<std::string_view>(names.begin(), names.end()));
+	}
+
+	expect(
+		perfect_hash_concatenation({ "type", "::", "field" }, 7) == perfect_hash_string("type::field", 7),
+		"hashing the parts of a key like the whole key"
+	);
+
+	expect(find_duplicate_key({ "A", "B", "A" }) == 2, "finding the repeated key");
+	expect(find_duplicate_key({ "A", "B" }) == 2, "finding no repeated key");
+
+	expect_throws<std::invalid_argument>([]() {
+		make_perfect_hash({ "A", "B", "A" });
+	}, "rejecting repeated keys");
+
+	{
+		introspected_type t;
+		t.struct_or_class_or_enum = "enum class";
+		t.type_name_without_templates = "dup";
+
+		for (const auto name : { "A", "B", "A" }) {
+			block_line l;
+			l.type = block_line_type::FIELD;
+			l.text = name;
+			t.lines.push_back(l);
+		}
+
+		generator_configuration cfg;
+		cfg.enum_lookup_format = format_template("%x %x %x %x %x %x %x\n");
+
+		expect_throws<header_parse_error>([&]() {
+			std::string out;
+			emit_enum_lookup(cfg, t, make_type_naming(t), out);
+		}, "reporting a repeated enumerator as a parse error");
+
+		t.lines.back().text = "C";
+
+		try {
+			std::string out;
+			emit_enum_lookup(cfg, t, make_type_naming(t), out);
+
+			expect(out.find("::dup 3 \"A\", \"B\", \"C\" ") == 0, "emitting the names of distinct enumerators in order");
+		}
+		catch (const std::exception& err) {
+			expect(false, std::string("emitting the lookup of distinct enumerators: ") + err.what());
+		}
+	}
+
+	if (num_failures > 0) {
+		std::cout << num_failures << " perfect_hash test(s) failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "All perfect_hash tests passed." << std::endl;
+	return 0;
+}
@@ -0,0 +1,134 @@
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "structural_hash.h"
+
+/*
+	Checks that field IDs never change for a name, that colliding IDs are reported,
+	and that structural hashes depend on the shape of the types alone, never on the order of the headers.
+*/
+
+static int num_failures = 0;
+
+static void expect(const bool condition, const std::string& what) {
+	if (!condition) {
+		++num_failures;
+		std::cout << "Failed: " << what << "\n";
+	}
+}
+
+/* Fields are given as { name, type }, and a field without a type is an intact line */
+
+static introspected_type make_type(
+	const std::string& struct_or_class_or_enum,
+	const std::string& name,
+	const std::vector<std::pair<std::string, std::string>>& fields
+) {
+	introspected_type t;
+	t.struct_or_class_or_enum = struct_or_class_or_enum;
+	t.type_name_without_templates = name;
+
+	for (const auto& f : fields) {
+		block_line l;
+		l.type = f.second.empty() && struct_or_class_or_enum != "enum class" ? block_line_type::INTACT : block_line_type::FIELD;
+		l.text = f.first;
+		l.field_type = f.second;
+		t.lines.push_back(l);
+	}
+
+	return t;
+}
+
+static bool rejects_field_ids(const introspected_types& types) {
+	scan_cache model;
+	model.entries["a.h"].types = types;
+
+	try {
+		check_field_ids({ "a.h" }, model);
+	}
+	catch (const header_parse_error&) {
+		return true;
+	}
+
+	return false;
+}
+
+/* Field hashes by the name of their type, for the headers in the given order */
+
+static std::map<std::string, std::vector<std::uint64_t>> hash_by_name(
+	const std::vector<std::string>& header_files,
+	const scan_cache& model
+) {
+	std::map<std::string, std::vector<std::uint64_t>> out;
+
+	for (const auto& h : make_structural_hashes(header_files, model).field_hashes) {
+		out[h.first->type_name_without_templates] = h.second;
+	}
+
+	return out;
+}
+
+int main() {
+	/* IDs end up in saved files, so they must never change between versions of the generator */
+	expect(make_field_id("x") == 0x86021707u, "keeping the field ID of a name");
+	expect(make_field_id("position") == make_field_id(std::string("position")), "making the ID from the name alone");
+
+	/* Two names known to share the low 32 bits of FNV-1a */
+	expect(make_field_id("f118781") == make_field_id("f742490"), "finding the known collision");
+
+	expect(rejects_field_ids({ make_type("struct", "s", { { "f118781", "int" }, { "f742490", "int" } }) }), "rejecting fields of one type with the same ID");
+	expect(!rejects_field_ids({ make_type("struct", "s", { { "f118781", "int" } }), make_type("struct", "t", { { "f742490", "int" } }) }), "allowing the same ID in different types");
+	expect(!rejects_field_ids({ make_type("enum class", "e", { { "f118781", "" }, { "f742490", "" } }) }), "ignoring the enumerators of enums");
+	expect(!rejects_field_ids({ make_type("struct", "s", { { "#if A", "" }, { "x", "int" }, { "#else", "" }, { "x", "float" }, { "#endif", "" } }) }), "allowing one field declared in several preprocessor branches");
+
+	{
+		scan_cache model;
+		model.entries["a.h"].types = { make_type("struct", "node_a", { { "next", "std::vector<node_b>" }, { "value", "int" } }) };
+		model.entries["b.h"].types = { make_type("struct", "node_b", { { "prev", "node_a*" } }), make_type("struct", "leaf", { { "v", "float" } }) };
+		model.entries["c.h"].types = { make_type("struct", "holder", { { "l", "leaf" }, { "n", "node_a" } }) };
+
+		const auto forward = hash_by_name({ "a.h", "b.h", "c.h" }, model);
+		const auto backward = hash_by_name({ "c.h", "b.h", "a.h" }, model);
+
+		expect(forward.size() == 4, "hashing every type");
+		expect(forward == backward, "hashing independently of the order of the headers");
+		expect(forward == hash_by_name({ "a.h", "b.h", "c.h" }, model), "hashing the same model the same way twice");
+
+		auto renamed = model;
+		renamed.entries["a.h"].types[0].lines[1].text = "amount";
+
+		const auto after_rename = hash_by_name({ "a.h", "b.h", "c.h" }, renamed);
+
+		expect(after_rename.at("node_a")[0] == forward.at("node_a")[0], "keeping the hash of an unchanged field");
+		expect(after_rename.at("node_a")[1] != forward.at("node_a")[1], "changing the hash of a renamed field");
+
+		auto retyped = model;
+		retyped.entries["b.h"].types[1].lines[0].field_type = "double";
+
+		const auto after_retype = hash_by_name({ "a.h", "b.h", "c.h" }, retyped);
+
+		expect(after_retype.at("leaf") != forward.at("leaf"), "changing the hash of a retyped field");
+		expect(after_retype.at("holder")[0] != forward.at("holder")[0], "changing the hash of a field whose type changed shape");
+		expect(after_retype.at("holder")[1] == forward.at("holder")[1], "keeping the hash of a field whose type kept its shape");
+
+		auto reordered = model;
+		auto& lines = reordered.entries["a.h"].types[0].lines;
+		std::swap(lines[0], lines[1]);
+
+		const auto after_reorder = hash_by_name({ "a.h", "b.h", "c.h" }, reordered);
+
+		expect(after_reorder.at("node_a")[0] == forward.at("node_a")[1], "keeping the hash of a moved field");
+		expect(after_reorder.at("holder")[1] != forward.at("holder")[1], "changing the hash of a field whose type was reordered");
+	}
+
+	if (num_failures > 0) {
+		std::cout << num_failures << " structural_hash test(s) failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "All structural_hash tests passed." << std::endl;
+	return 0;
+}